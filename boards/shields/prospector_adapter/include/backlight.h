@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+// Set the backlight immediately, cancelling any fade in progress
+int bl_set(uint8_t brightness);
+
+// Fade the backlight towards target without blocking the caller, a fade in
+// progress is retargeted rather than restarted
+void bl_fade_to(uint8_t target);
+
+// Brightness currently applied to the backlight
+uint8_t bl_get(void);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Count the frames and pixels disp renders for the idle power report
+void display_power_monitor(lv_disp_t *disp);
+
+// Bring the display back ahead of the first keypress, called from the system
+// work queue when the proximity sensor sees a hand
+void display_power_prewake(void);
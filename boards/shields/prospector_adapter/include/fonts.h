@@ -1,18 +1,30 @@
 #pragma once
 
 #include <lvgl.h>
+#include <zephyr/sys/util.h>
+
+// Declared only when the font is selected in Kconfig, a widget that uses a font
+// without selecting it fails to compile rather than to link
 
 // LV_FONT_DECLARE(SF_Compact_Text_Light_24);
 // LV_FONT_DECLARE(SF_Compact_Text_Semibold_28);
+#if IS_ENABLED(CONFIG_PROSPECTOR_FONT_SF_COMPACT_TEXT_BOLD_32)
 LV_FONT_DECLARE(SF_Compact_Text_Bold_32);
+#endif
 // LV_FONT_DECLARE(InterDisplay_Light_40);
 // LV_FONT_DECLARE(InterDisplay_Thin_56);
 // LV_FONT_DECLARE(InterDisplay_Bold_56);
+#if IS_ENABLED(CONFIG_PROSPECTOR_FONT_FOUNDRYGRIDNIKMEDIUM_20)
 LV_FONT_DECLARE(FoundryGridnikMedium_20);
+#endif
 // LV_FONT_DECLARE(FoundryGridnikRegular_28);
 // LV_FONT_DECLARE(FoundryGridnikLight_48);
 // LV_FONT_DECLARE(FoundryGridnikRegular_48);
 // LV_FONT_DECLARE(PPSupplySans_Thin_64);
 // LV_FONT_DECLARE(PPSupplySans_Light_64);
+#if IS_ENABLED(CONFIG_PROSPECTOR_FONT_FRAC_THIN_48)
 LV_FONT_DECLARE(FRAC_Thin_48);
+#endif
+#if IS_ENABLED(CONFIG_PROSPECTOR_FONT_FRAC_REGULAR_48)
 LV_FONT_DECLARE(FRAC_Regular_48);
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zmk/ble.h>
+
+// Bits of the indicator snapshot, one for every value the screen shows. Each
+// peripheral gets one bit per indicator, starting at the range base plus slot.
+enum indicator_bit {
+    INDICATOR_CAPS_WORD,
+    // Host lock states from HID output reports
+    INDICATOR_CAPS_LOCK,
+    INDICATOR_NUM_LOCK,
+    INDICATOR_SCROLL_LOCK,
+    INDICATOR_CONNECTED_BASE,
+    INDICATOR_BATTERY_BASE = INDICATOR_CONNECTED_BASE + ZMK_SPLIT_BLE_PERIPHERAL_COUNT,
+    INDICATOR_BIT_COUNT = INDICATOR_BATTERY_BASE + ZMK_SPLIT_BLE_PERIPHERAL_COUNT,
+};
+
+#define INDICATOR_RANGE(base, count) GENMASK((base) + (count)-1, (base))
+
+#define INDICATOR_CONNECTED_MASK                                                                   \
+    INDICATOR_RANGE(INDICATOR_CONNECTED_BASE, ZMK_SPLIT_BLE_PERIPHERAL_COUNT)
+#define INDICATOR_BATTERY_MASK                                                                     \
+    INDICATOR_RANGE(INDICATOR_BATTERY_BASE, ZMK_SPLIT_BLE_PERIPHERAL_COUNT)
+
+// Everything the indicators show, the on/off ones packed into flags by bit
+struct indicator_state {
+    uint32_t flags;
+    uint8_t battery[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+};
+
+// Called on the display work queue at most once per LVGL refresh period, with
+// the bits of mask that changed since the last call
+struct indicator_subscriber {
+    sys_snode_t node;
+    uint32_t mask;
+    void (*cb)(const struct indicator_state *state, uint32_t changed);
+};
+
+// Register sub unless it already is, then call it right away with every bit
+// in its mask that has a value yet so a newly created widget catches up. Must
+// be called from the display work queue.
+void indicators_subscribe(struct indicator_subscriber *sub);
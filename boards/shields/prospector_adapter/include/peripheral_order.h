@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Position of the split peripheral in slot on screen, counted from the left
+uint8_t peripheral_order_position(uint8_t slot);
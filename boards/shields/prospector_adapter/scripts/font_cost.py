@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# Estimates the flash taken by LVGL fonts generated with lv_font_conv, so the
+# build can report what every selected font costs.
+#
+# SPDX-License-Identifier: MIT
+
+import argparse
+import os
+import re
+import sys
+
+# Sizes of the LVGL 8 font structures that are arrays in the generated source
+STRUCT_SIZES = {
+    "lv_font_fmt_txt_glyph_dsc_t": 8,
+    "lv_font_fmt_txt_cmap_t": 20,
+}
+
+INT_SIZES = {
+    "uint8_t": 1,
+    "int8_t": 1,
+    "uint16_t": 2,
+    "int16_t": 2,
+}
+
+# Descriptors, cache and the public lv_font_t
+FIXED_COST = 96
+
+ARRAY_RE = re.compile(
+    r"^static\s+(?:LV_ATTRIBUTE_LARGE_CONST\s+)?const\s+(\w+)\s+(\w+)\[\]\s*=\s*\{(.*?)^\};",
+    re.MULTILINE | re.DOTALL,
+)
+COMMENT_RE = re.compile(r"/\*.*?\*/", re.DOTALL)
+NUMBER_RE = re.compile(r"-?(?:0x[0-9a-fA-F]+|\d+)")
+
+
+def array_cost(c_type, body):
+    body = COMMENT_RE.sub("", body)
+    if c_type in STRUCT_SIZES:
+        return body.count("{") * STRUCT_SIZES[c_type]
+    if c_type in INT_SIZES:
+        return len(NUMBER_RE.findall(body)) * INT_SIZES[c_type]
+    return 0
+
+
+def font_cost(path):
+    with open(path) as f:
+        source = f.read()
+
+    glyphs = len(re.findall(r"/\* U\+[0-9A-F]+ ", source))
+    size = FIXED_COST + sum(array_cost(t, body) for t, _, body in ARRAY_RE.findall(source))
+    return glyphs, size
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--selected", nargs="*", default=[], help="fonts linked into the image")
+    parser.add_argument("--skipped", nargs="*", default=[], help="fonts left out of the build")
+    args = parser.parse_args()
+
+    total = 0
+    for path in args.selected:
+        glyphs, size = font_cost(path)
+        total += size
+        name = os.path.splitext(os.path.basename(path))[0]
+        print(f"Prospector font {name}: {glyphs} glyphs, about {size} B of flash")
+
+    skipped = sum(font_cost(path)[1] for path in args.skipped)
+    print(
+        f"Prospector fonts: {len(args.selected)} selected, about {total} B of flash, "
+        f"{len(args.skipped)} not built, about {skipped} B"
+    )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+#
+# Generates the ambient light to backlight duty cycle lookup table so the
+# curve is evaluated once at build time instead of on every sample.
+#
+# SPDX-License-Identifier: MIT
+
+import argparse
+import math
+import os
+import sys
+
+
+def curve(x, kind, param):
+    if kind == "log":
+        return math.log1p(param * x) / math.log1p(param)
+    if kind == "gamma":
+        # Lift low readings, the eye is more sensitive to changes in the dark
+        return x ** (10.0 / param)
+    return x
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--curve", choices=("linear", "log", "gamma"), required=True)
+    parser.add_argument("--param", type=int, default=0)
+    parser.add_argument("--sensor-max", type=int, required=True)
+    parser.add_argument("--pwm-min", type=int, required=True)
+    parser.add_argument("--pwm-max", type=int, required=True)
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+
+    lut = []
+    for reading in range(args.sensor_max + 1):
+        y = curve(reading / args.sensor_max, args.curve, args.param)
+        lut.append(round(args.pwm_min + (args.pwm_max - args.pwm_min) * y))
+
+    rows = []
+    for i in range(0, len(lut), 16):
+        rows.append("    " + ", ".join(str(v) for v in lut[i : i + 16]) + ",")
+
+    header = (
+        "/* Generated by gen_als_curve.py, do not edit */\n"
+        "\n"
+        "#pragma once\n"
+        "\n"
+        "#include <stdint.h>\n"
+        "\n"
+        f"#define ALS_CURVE_SENSOR_MAX {args.sensor_max}\n"
+        f"#define ALS_CURVE_PWM_MIN {args.pwm_min}\n"
+        f"#define ALS_CURVE_PWM_MAX {args.pwm_max}\n"
+        "\n"
+        f"/* {args.curve} curve, parameter {args.param} */\n"
+        "static const uint8_t als_curve_lut[ALS_CURVE_SENSOR_MAX + 1] = {\n"
+        + "\n".join(rows)
+        + "\n};\n"
+    )
+
+    # Only touch the header when it changes to avoid needless rebuilds
+    if os.path.exists(args.output):
+        with open(args.output) as f:
+            if f.read() == header:
+                return 0
+
+    os.makedirs(os.path.dirname(args.output), exist_ok=True)
+    with open(args.output, "w") as f:
+        f.write(header)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
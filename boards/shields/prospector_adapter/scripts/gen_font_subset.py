@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+#
+# Cuts an lv_font_conv generated font down to the glyphs of the keymap's layer
+# names, so a roller font carries the 20 or so characters it can ever show
+# instead of all of ASCII. Exits non-zero without writing anything when the
+# font can't be subset, in which case the build keeps the full font.
+#
+# SPDX-License-Identifier: MIT
+
+import argparse
+import os
+import re
+import sys
+
+from gen_layer_names import layer_names, load_edt
+
+GLYPH_RE = re.compile(r"^\s*/\* U\+([0-9A-F]+) .*\*/\s*$")
+DSC_RE = re.compile(r"^\s*(\{\.bitmap_index = (\d+),[^}]*\})")
+NUMBER_RE = re.compile(r"0x[0-9a-fA-F]+")
+
+
+class SubsetError(Exception):
+    pass
+
+
+def field(source, name):
+    match = re.search(r"\." + name + r" = (-?\d+)", source)
+    if not match:
+        raise SubsetError(f"no {name} in font")
+    return int(match.group(1))
+
+
+def block(source, start):
+    begin = source.find(start)
+    if begin < 0:
+        raise SubsetError(f"no '{start}' in font")
+    end = source.find("};", begin)
+    return source[begin:end].splitlines()[1:]
+
+
+def parse_font(source):
+    if not re.search(r"\.kern_dsc = NULL", source) or field(source, "bitmap_format") != 0:
+        raise SubsetError("kerning and compressed fonts are not supported")
+
+    name = re.search(r"^const lv_font_t (\w+) = \{", source, re.MULTILINE)
+    if not name:
+        raise SubsetError("no public font descriptor")
+
+    # The bitmap lists every glyph under a U+ comment, in glyph id order
+    glyphs = []
+    for line in block(source, "glyph_bitmap[] = {"):
+        match = GLYPH_RE.match(line)
+        if match:
+            glyphs.append({"code": int(match.group(1), 16), "lines": []})
+        elif glyphs and line.strip():
+            glyphs[-1]["lines"].append(line)
+
+    dscs = [m.group(1) for m in map(DSC_RE.match, block(source, "glyph_dsc[] = {")) if m]
+    if len(dscs) != len(glyphs) + 1:
+        raise SubsetError("glyph descriptions don't match the bitmaps")
+
+    offset = 0
+    for glyph, dsc in zip(glyphs, dscs[1:]):
+        if int(DSC_RE.match(dsc).group(2)) != offset:
+            raise SubsetError(f"unexpected bitmap layout at U+{glyph['code']:04X}")
+        glyph["size"] = sum(len(NUMBER_RE.findall(line)) for line in glyph["lines"])
+        glyph["dsc"] = dsc
+        offset += glyph["size"]
+
+    return {
+        "name": name.group(1),
+        "glyphs": glyphs,
+        "bpp": field(source, "bpp"),
+        "line_height": field(source, "line_height"),
+        "base_line": field(source, "base_line"),
+        "underline_position": field(source, "underline_position"),
+        "underline_thickness": field(source, "underline_thickness"),
+        "opts": re.search(r"^ \* Opts: (.*)$", source, re.MULTILINE),
+    }
+
+
+def cmap(codes):
+    start = codes[0]
+    length = codes[-1] - start + 1
+    if length == len(codes):
+        return "", (
+            f"        .range_start = {start}, .range_length = {length}, .glyph_id_start = 1,\n"
+            "        .unicode_list = NULL, .glyph_id_ofs_list = NULL, .list_length = 0, "
+            ".type = LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY\n"
+        )
+
+    offsets = ", ".join(f"0x{c - start:x}" for c in codes)
+    return (
+        f"static const uint16_t unicode_list_0[] = {{\n    {offsets}\n}};\n\n",
+        f"        .range_start = {start}, .range_length = {length}, .glyph_id_start = 1,\n"
+        f"        .unicode_list = unicode_list_0, .glyph_id_ofs_list = NULL, "
+        f".list_length = {len(codes)}, .type = LV_FONT_FMT_TXT_CMAP_SPARSE_TINY\n",
+    )
+
+
+def render(font, glyphs, source_name):
+    guard = font["name"].upper()
+    bitmap = []
+    dscs = ["    {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} "
+            "/* id = 0 reserved */"]
+    offset = 0
+    for glyph in glyphs:
+        bitmap.append(f"    /* U+{glyph['code']:04X} {repr(chr(glyph['code']))} */")
+        bitmap.extend(glyph["lines"])
+        bitmap.append("")
+        dscs.append("    " + re.sub(r"bitmap_index = \d+", f"bitmap_index = {offset}", glyph["dsc"]))
+        offset += glyph["size"]
+
+    unicode_list, cmap_entry = cmap([g["code"] for g in glyphs])
+    opts = f" * Subset of {source_name}"
+    if font["opts"]:
+        opts += f", generated with {font['opts'].group(1)}"
+
+    return f"""/* Generated by gen_font_subset.py, do not edit */
+#include <lvgl.h>
+
+/*******************************************************************************
+{opts}
+ ******************************************************************************/
+
+#ifndef {guard}
+#define {guard} 1
+#endif
+
+#if {guard}
+
+static LV_ATTRIBUTE_LARGE_CONST const uint8_t glyph_bitmap[] = {{
+{chr(10).join(bitmap).rstrip()}
+}};
+
+static const lv_font_fmt_txt_glyph_dsc_t glyph_dsc[] = {{
+{("," + chr(10)).join(dscs)}
+}};
+
+{unicode_list}static const lv_font_fmt_txt_cmap_t cmaps[] = {{
+    {{
+{cmap_entry}    }}
+}};
+
+#if LVGL_VERSION_MAJOR == 8
+static lv_font_fmt_txt_glyph_cache_t cache;
+#endif
+
+static const lv_font_fmt_txt_dsc_t font_dsc = {{
+    .glyph_bitmap = glyph_bitmap,
+    .glyph_dsc = glyph_dsc,
+    .cmaps = cmaps,
+    .kern_dsc = NULL,
+    .kern_scale = 0,
+    .cmap_num = 1,
+    .bpp = {font["bpp"]},
+    .kern_classes = 0,
+    .bitmap_format = 0,
+#if LVGL_VERSION_MAJOR == 8
+    .cache = &cache
+#endif
+}};
+
+const lv_font_t {font["name"]} = {{
+    .get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt,
+    .get_glyph_bitmap = lv_font_get_bitmap_fmt_txt,
+    .line_height = {font["line_height"]},
+    .base_line = {font["base_line"]},
+    .subpx = LV_FONT_SUBPX_NONE,
+    .underline_position = {font["underline_position"]},
+    .underline_thickness = {font["underline_thickness"]},
+    .dsc = &font_dsc,
+#if LV_VERSION_CHECK(8, 2, 0) || LVGL_VERSION_MAJOR >= 9
+    .fallback = NULL,
+#endif
+    .user_data = NULL,
+}};
+
+#endif /*#if {guard}*/
+"""
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--edt-pickle", required=True)
+    parser.add_argument("--zephyr-base", required=True)
+    parser.add_argument("--all-caps", action="store_true")
+    parser.add_argument("--extra", default="", help="characters to keep besides the layer names")
+    parser.add_argument("--font", required=True)
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+
+    names = layer_names(load_edt(args.edt_pickle, args.zephyr_base), args.all_caps)
+    wanted = set("".join(names) + args.extra)
+
+    with open(args.font) as f:
+        source = f.read()
+
+    try:
+        font = parse_font(source)
+    except SubsetError as e:
+        print(f"{os.path.basename(args.font)}: {e}", file=sys.stderr)
+        return 1
+
+    glyphs = [g for g in font["glyphs"] if chr(g["code"]) in wanted]
+    missing = wanted - {chr(g["code"]) for g in glyphs}
+    if missing:
+        # These would not render with the full font either
+        print(f"{os.path.basename(args.font)} has no glyph for {''.join(sorted(missing))!r}",
+              file=sys.stderr)
+    if not glyphs:
+        print(f"{os.path.basename(args.font)}: no glyphs to keep", file=sys.stderr)
+        return 1
+
+    output = render(font, glyphs, os.path.basename(args.font))
+
+    # Only touch the output when it changes to avoid needless rebuilds
+    if os.path.exists(args.output):
+        with open(args.output) as f:
+            if f.read() == output:
+                return 0
+
+    os.makedirs(os.path.dirname(args.output), exist_ok=True)
+    with open(args.output, "w") as f:
+        f.write(output)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
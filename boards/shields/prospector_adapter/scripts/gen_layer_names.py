@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+#
+# Generates the layer roller's name table from the keymap's layer nodes so
+# it can live in flash instead of being assembled at startup.
+#
+# SPDX-License-Identifier: MIT
+
+import argparse
+import os
+import pickle
+import sys
+
+
+def load_edt(edt_pickle, zephyr_base):
+    sys.path.insert(0, os.path.join(zephyr_base, "scripts", "dts", "python-devicetree", "src"))
+    with open(edt_pickle, "rb") as f:
+        return pickle.load(f)
+
+
+def layer_names(edt, all_caps):
+    keymaps = edt.compat2okay.get("zmk,keymap") or edt.compat2nodes.get("zmk,keymap") or []
+    if not keymaps:
+        return []
+
+    names = []
+    for i, layer in enumerate(keymaps[0].children.values()):
+        name = ""
+        for prop in ("display-name", "label"):
+            if prop in layer.props and layer.props[prop].val:
+                name = layer.props[prop].val
+                break
+
+        if not name:
+            # Just use the number for unnamed layers
+            name = str(i)
+        elif all_caps:
+            name = "".join(c.upper() if c.isascii() else c for c in name)
+
+        names.append(name)
+
+    return names
+
+
+def c_string(s):
+    out = []
+    for b in s.encode("utf-8"):
+        c = chr(b)
+        if c in ('"', "\\"):
+            out.append("\\" + c)
+        elif c == "\n":
+            out.append("\\n")
+        elif 0x20 <= b < 0x7F:
+            out.append(c)
+        else:
+            out.append("\\%03o" % b)
+    return '"' + "".join(out) + '"'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--edt-pickle", required=True)
+    parser.add_argument("--zephyr-base", required=True)
+    parser.add_argument("--all-caps", action="store_true")
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+
+    names = layer_names(load_edt(args.edt_pickle, args.zephyr_base), args.all_caps)
+
+    header = (
+        "/* Generated by gen_layer_names.py, do not edit */\n"
+        "\n"
+        "#pragma once\n"
+        "\n"
+        f"#define PROSPECTOR_LAYER_NAMES_COUNT {len(names)}\n"
+        f"#define PROSPECTOR_LAYER_NAMES {', '.join(c_string(n) for n in names)}\n"
+    )
+
+    # Only touch the header when it changes to avoid needless rebuilds
+    if os.path.exists(args.output):
+        with open(args.output) as f:
+            if f.read() == header:
+                return 0
+
+    os.makedirs(os.path.dirname(args.output), exist_ok=True)
+    with open(args.output, "w") as f:
+        f.write(header)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
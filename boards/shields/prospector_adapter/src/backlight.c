@@ -0,0 +1,63 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led.h>
+
+#include <backlight.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(als, 4);
+
+static const struct device *pwm_leds_dev = DEVICE_DT_GET_ONE(pwm_leds);
+#define DISP_BL DT_NODE_CHILD_IDX(DT_NODELABEL(disp_bl))
+
+#define FADE_STEP                        1
+#define FADE_SLEEP_BRIGHTEN_MS           3
+#define FADE_SLEEP_DARKEN_MS             10
+
+static uint8_t brightness = 100;
+static uint8_t target = 100;
+
+static void bl_fade_step(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(fade_work, bl_fade_step);
+
+// One step per run, rescheduling itself until the target is reached, so a
+// fade never holds up the caller and picks up a new target on the next step
+static void bl_fade_step(struct k_work *work) {
+    uint8_t goal = target;
+
+    if (brightness == goal) {
+        return;
+    }
+
+    bool increasing = goal > brightness;
+    if (increasing) {
+        brightness = MIN(brightness + FADE_STEP, goal);
+    } else {
+        brightness = MAX(brightness - FADE_STEP, goal);
+    }
+
+    if (led_set_brightness(pwm_leds_dev, DISP_BL, brightness)) {
+        LOG_ERR("Failed to set brightness");
+    }
+
+    if (brightness != goal) {
+        k_work_schedule(&fade_work,
+                        K_MSEC(increasing ? FADE_SLEEP_BRIGHTEN_MS : FADE_SLEEP_DARKEN_MS));
+    }
+}
+
+int bl_set(uint8_t level) {
+    k_work_cancel_delayable(&fade_work);
+
+    target = level;
+    brightness = level;
+
+    return led_set_brightness(pwm_leds_dev, DISP_BL, level);
+}
+
+void bl_fade_to(uint8_t level) {
+    target = level;
+    k_work_schedule(&fade_work, K_NO_WAIT);
+}
+
+uint8_t bl_get(void) { return brightness; }
@@ -1,158 +1,594 @@
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
-#include <zephyr/drivers/sensor.h>
-#include <zephyr/drivers/pwm.h>
-#include <zephyr/drivers/led.h>
-#include <zephyr/sys/printk.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/byteorder.h>
+#include <stdlib.h>
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+#include <zephyr/settings/settings.h>
+#endif
+
+#if IS_ENABLED(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include <backlight.h>
+#include <prospector/brightness.h>
+
+#ifdef CONFIG_PROSPECTOR_PROXIMITY_WAKE
+#include <display_power.h>
+#endif
+
+#ifdef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+#include <prospector_als_curve.h>
+#endif
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(als, 4);
 
-static const struct device *pwm_leds_dev = DEVICE_DT_GET_ONE(pwm_leds);
-#define DISP_BL DT_NODE_CHILD_IDX(DT_NODELABEL(disp_bl))
+#define BRIGHTNESS_MIN 1
+#define BRIGHTNESS_MAX 100
+
+struct brightness_settings {
+    bool manual;
+    uint8_t level;
+    int8_t offset;
+};
+
+static struct brightness_settings brightness_settings = {
+#ifdef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+    .manual = false,
+    .level = BRIGHTNESS_MAX,
+#else
+    .manual = true,
+    .level = CONFIG_PROSPECTOR_FIXED_BRIGHTNESS,
+#endif
+    .offset = 0,
+};
+
+// Ceiling applied on top of the user's setting, lowered while the display is
+// idle so dimming never touches the saved brightness
+static uint8_t brightness_limit = BRIGHTNESS_MAX;
+
+static uint8_t brightness_target(void);
 
 #ifdef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
 
 static uint8_t current_brightness = 100;
 
-#define SENSOR_MIN      0       // Minimum sensor reading
-#define SENSOR_MAX      100   // Maximum sensor reading
-#define PWM_MIN         1       // Minimum PWM duty cycle (%) - keep display visible
-#define PWM_MAX         100     // Maximum PWM duty cycle (%)
+// Reading the current brightness was mapped from, -1 until the first one
+static int32_t applied_reading = -1;
 
-#define FADE_STEP                        1
-#define FADE_SLEEP_BRIGHTEN_MS           3
-#define FADE_SLEEP_DARKEN_MS             10
-#define FADE_THRESHOLD                   10
+// Readings within this many counts of the applied one are treated as noise.
+// Applied to the reading rather than the brightness, as the curve is steep
+// enough in the dark for a single count to move the brightness several %.
+#define ALS_HYSTERESIS                   CONFIG_PROSPECTOR_ALS_HYSTERESIS
 
 #define NORMAL_SAMPLE_SLEEP_MS           100
 
-#define BURST_SAMPLE_SLEEP_MS            30
-#define BURST_SAMPLE_TIMEOUT             10
-#define BURST_SAMPLE_CONSECUTIVE         3
+// Consecutive out-of-window readings before the sensor raises an interrupt
+#define INTERRUPT_PERSISTENCE            3
+
+#define STATS_REPORT_INTERVAL_MS         (60 * 60 * 1000)
+
+struct als_stats {
+    uint32_t wakeups;
+    uint32_t sensor_reads;
+    uint32_t threshold_writes;
+    uint32_t brightness_changes;
+    int64_t since;
+};
+
+static struct als_stats stats;
+
+static void als_stats_report(void) {
+    int64_t elapsed = k_uptime_get() - stats.since;
+    if (elapsed < STATS_REPORT_INTERVAL_MS) {
+        return;
+    }
+
+    LOG_INF("%s mode, last %d min: %u wakeups, %u sensor reads, %u threshold writes, "
+            "%u brightness changes",
+            IS_ENABLED(CONFIG_PROSPECTOR_ALS_INTERRUPT) ? "interrupt" : "polling",
+            (int)(elapsed / 60000), stats.wakeups, stats.sensor_reads, stats.threshold_writes,
+            stats.brightness_changes);
+
+    stats = (struct als_stats){.since = k_uptime_get()};
+}
 
 uint8_t map_light_to_pwm(int32_t sensor_reading) {
     // Handle invalid/error readings
-    if (sensor_reading < SENSOR_MIN) {
-        return PWM_MIN;  // Default to minimum brightness on error
+    if (sensor_reading < 0) {
+        return ALS_CURVE_PWM_MIN;  // Default to minimum brightness on error
     }
 
-    // Clamp to maximum
-    if (sensor_reading > SENSOR_MAX) {
-        sensor_reading = SENSOR_MAX;
+    return als_curve_lut[MIN(sensor_reading, ALS_CURVE_SENSOR_MAX)];
+}
+
+static void als_apply(int32_t reading) {
+    reading = CLAMP(reading, 0, ALS_CURVE_SENSOR_MAX);
+    if (applied_reading >= 0 && abs(reading - applied_reading) <= ALS_HYSTERESIS) {
+        return;
     }
 
-    // Linear mapping
-    uint8_t pwm_value = (uint8_t)(
-        PWM_MIN + ((PWM_MAX - PWM_MIN) *
-        (sensor_reading - SENSOR_MIN)) / (SENSOR_MAX - SENSOR_MIN)
-    );
+    applied_reading = reading;
+    uint8_t mapped_brightness = map_light_to_pwm(reading);
+    if (mapped_brightness != current_brightness) {
+        current_brightness = mapped_brightness;
+        if (!brightness_settings.manual) {
+            bl_fade_to(brightness_target());
+            stats.brightness_changes++;
+        }
+    }
+}
+
+// The Zephyr APDS9960 driver only supports proximity thresholds and powers
+// the chip down after every fetch, which then blocks for a full integration
+// cycle. Once the driver has set the chip up, the ALS engine is left running
+// and its clear channel and interrupt window are accessed directly instead.
+#define APDS9960_ENABLE_REG              0x80
+#define APDS9960_ENABLE_PON              BIT(0)
+#define APDS9960_ENABLE_AEN              BIT(1)
+#define APDS9960_ENABLE_PEN              BIT(2)
+#define APDS9960_ENABLE_AIEN             BIT(4)
+#define APDS9960_ENABLE_PIEN             BIT(5)
+#define APDS9960_AILTL_REG               0x84
+#define APDS9960_PILT_REG                0x89
+#define APDS9960_PIHT_REG                0x8B
+#define APDS9960_PERS_REG                0x8C
+#define APDS9960_PERS_APERS_MASK         0x0F
+#define APDS9960_PERS_PPERS_SHIFT        4
+#define APDS9960_PERS_PPERS_MASK         0xF0
+#define APDS9960_CDATAL_REG              0x94
+#define APDS9960_PDATA_REG               0x9C
+#define APDS9960_AICLEAR_REG             0xE7
+
+static const struct i2c_dt_spec als_i2c = I2C_DT_SPEC_GET(DT_NODELABEL(apds9960));
+
+static void als_work_cb(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(als_work, als_work_cb);
+
+static int als_read(int32_t *reading) {
+    uint8_t buf[2];
+
+    stats.sensor_reads++;
+    if (i2c_burst_read_dt(&als_i2c, APDS9960_CDATAL_REG, buf, sizeof(buf))) {
+        return -EIO;
+    }
 
-    return pwm_value;
+    *reading = sys_get_le16(buf);
+    return 0;
 }
 
-uint8_t bl_fade(uint8_t source, uint8_t target) {
-    bool increasing = target > source;
+#if defined(CONFIG_PROSPECTOR_ALS_INTERRUPT) || defined(CONFIG_PROSPECTOR_PROXIMITY_WAKE)
+#define ALS_USE_INT_GPIO
+
+static const struct gpio_dt_spec als_int = GPIO_DT_SPEC_GET(DT_NODELABEL(apds9960), int_gpios);
+
+static struct gpio_callback als_int_cb;
+
+#ifdef CONFIG_PROSPECTOR_PROXIMITY_WAKE
+// Set while the display is off and only the proximity engine is armed
+static bool als_suspended;
+
+static void prox_work_cb(struct k_work *work);
+static K_WORK_DEFINE(prox_work, prox_work_cb);
+#endif
+
+// The ALS and proximity engines share the INT line, but only one of them is
+// armed at a time depending on whether the display is on. The line is armed
+// level triggered, so an interrupt latched between clearing the sensor and
+// arming the GPIO still fires, and the handler disarms it until the work
+// item has serviced the sensor.
+static void als_int_handler(const struct device *port, struct gpio_callback *cb,
+                            gpio_port_pins_t pins) {
+    gpio_pin_interrupt_configure_dt(&als_int, GPIO_INT_DISABLE);
+#ifdef CONFIG_PROSPECTOR_PROXIMITY_WAKE
+    if (als_suspended) {
+        k_work_submit(&prox_work);
+        return;
+    }
+#endif
+    k_work_reschedule(&als_work, K_NO_WAIT);
+}
 
-    while ((increasing && current_brightness < target) ||
-           (!increasing && current_brightness > target)) {
+#endif
 
-        if (led_set_brightness(pwm_leds_dev, DISP_BL, current_brightness)) {
-            LOG_ERR("Failed to set brightness");
-        }
+#ifdef CONFIG_PROSPECTOR_ALS_INTERRUPT
 
-        current_brightness += increasing ? FADE_STEP : -FADE_STEP;
+#define ALS_ENABLE_BITS (APDS9960_ENABLE_PON | APDS9960_ENABLE_AEN | APDS9960_ENABLE_AIEN)
 
-        // Ensure we don't overshoot bounds
-        if (current_brightness > 100) {
-            current_brightness = 100;
-        } else if (current_brightness < 0) {
-            current_brightness = 0;
-        }
+// Program the ALS interrupt window to the hysteresis band around the applied
+// reading, so the next wakeup only happens once the light leaves it
+static int als_arm(void) {
+    int32_t center = MAX(applied_reading, 0);
+    int32_t low = MAX(center - ALS_HYSTERESIS, 0);
+    int32_t high = center + ALS_HYSTERESIS;
+    uint8_t buf[4];
+
+    sys_put_le16(low, &buf[0]);
+    sys_put_le16(high < ALS_CURVE_SENSOR_MAX ? high : UINT16_MAX, &buf[2]);
+
+    stats.threshold_writes++;
+    if (i2c_burst_write_dt(&als_i2c, APDS9960_AILTL_REG, buf, sizeof(buf)) ||
+        i2c_reg_write_byte_dt(&als_i2c, APDS9960_AICLEAR_REG, 0)) {
+        return -EIO;
+    }
+
+    return gpio_pin_interrupt_configure_dt(&als_int, GPIO_INT_LEVEL_ACTIVE);
+}
 
-        k_msleep(increasing ? FADE_SLEEP_BRIGHTEN_MS : FADE_SLEEP_DARKEN_MS);
+static int als_start(void) {
+    // The hardware persistence filter takes the place of the software filter
+    if (i2c_reg_update_byte_dt(&als_i2c, APDS9960_PERS_REG, APDS9960_PERS_APERS_MASK,
+                               INTERRUPT_PERSISTENCE) ||
+        i2c_reg_update_byte_dt(&als_i2c, APDS9960_ENABLE_REG, ALS_ENABLE_BITS,
+                               ALS_ENABLE_BITS)) {
+        return -EIO;
     }
 
     return 0;
 }
 
-extern void als_thread(void *d0, void *d1, void *d2) {
-    ARG_UNUSED(d0);
-    ARG_UNUSED(d1);
-    ARG_UNUSED(d2);
+static void als_work_cb(struct k_work *work) {
+    int32_t reading;
+
+    stats.wakeups++;
+    als_stats_report();
 
-    const struct device *dev;
-    struct sensor_value intensity;
-    uint8_t mapped_brightness;
+    if (als_read(&reading)) {
+        LOG_ERR("Cannot read ALS data.");
+    } else {
+        als_apply(reading);
+    }
+
+    if (als_arm()) {
+        LOG_ERR("Failed to arm ALS interrupt");
+    }
+}
+
+#else
+
+#define ALS_ENABLE_BITS (APDS9960_ENABLE_PON | APDS9960_ENABLE_AEN)
+
+static int als_start(void) {
+    return i2c_reg_update_byte_dt(&als_i2c, APDS9960_ENABLE_REG, ALS_ENABLE_BITS,
+                                  ALS_ENABLE_BITS);
+}
+
+// Exponential moving average of the clamped reading in Q8 fixed point
+static int32_t als_filter_q8 = -1;
+
+static int32_t als_filter(int32_t reading) {
+    int32_t sample_q8 = CLAMP(reading, 0, ALS_CURVE_SENSOR_MAX) << 8;
+
+    if (als_filter_q8 < 0) {
+        als_filter_q8 = sample_q8;
+    } else {
+        als_filter_q8 += (sample_q8 - als_filter_q8) / (1 << CONFIG_PROSPECTOR_ALS_FILTER_SHIFT);
+    }
+
+    return (als_filter_q8 + 128) >> 8;
+}
+
+static void als_work_cb(struct k_work *work) {
+    int32_t reading;
+
+    stats.wakeups++;
+    als_stats_report();
+
+    if (als_read(&reading)) {
+        LOG_ERR("Cannot read ALS data.");
+    } else {
+        // LOG_INF("ambient light intensity %d", reading);
+        als_apply(als_filter(reading));
+    }
+
+    k_work_schedule(&als_work, K_MSEC(NORMAL_SAMPLE_SLEEP_MS));
+}
+
+#endif // CONFIG_PROSPECTOR_ALS_INTERRUPT
+
+#ifdef CONFIG_PROSPECTOR_PROXIMITY_WAKE
+
+#define PROX_ENABLE_BITS (APDS9960_ENABLE_PON | APDS9960_ENABLE_PEN | APDS9960_ENABLE_PIEN)
+
+// Consecutive close readings before the proximity engine raises an interrupt
+#define PROXIMITY_PERSISTENCE            2
+
+// While the display is off only the proximity engine runs, interrupting once
+// something comes closer than the wake threshold
+static int prox_arm(void) {
+    if (i2c_reg_write_byte_dt(&als_i2c, APDS9960_PILT_REG, 0) ||
+        i2c_reg_write_byte_dt(&als_i2c, APDS9960_PIHT_REG,
+                              CONFIG_PROSPECTOR_PROXIMITY_WAKE_THRESHOLD) ||
+        i2c_reg_update_byte_dt(&als_i2c, APDS9960_PERS_REG, APDS9960_PERS_PPERS_MASK,
+                               PROXIMITY_PERSISTENCE << APDS9960_PERS_PPERS_SHIFT) ||
+        i2c_reg_update_byte_dt(&als_i2c, APDS9960_ENABLE_REG, ALS_ENABLE_BITS | PROX_ENABLE_BITS,
+                               PROX_ENABLE_BITS) ||
+        i2c_reg_write_byte_dt(&als_i2c, APDS9960_AICLEAR_REG, 0)) {
+        return -EIO;
+    }
+
+    return gpio_pin_interrupt_configure_dt(&als_int, GPIO_INT_LEVEL_ACTIVE);
+}
+
+static void prox_work_cb(struct k_work *work) {
+    uint8_t proximity = 0;
+
+    i2c_reg_read_byte_dt(&als_i2c, APDS9960_PDATA_REG, &proximity);
+    LOG_DBG("Proximity %d, waking the display", proximity);
+
+    display_power_prewake();
+}
+
+#endif // CONFIG_PROSPECTOR_PROXIMITY_WAKE
+
+// The controller runs entirely from als_work on the system work queue, so it
+// needs no thread or stack of its own
+static int als_init(void) {
+    const struct device *dev = DEVICE_DT_GET_ONE(avago_apds9960);
 
-    dev = DEVICE_DT_GET_ONE(avago_apds9960);
     if (!device_is_ready(dev)) {
-        printk("sensor: device not ready.\n");
+        LOG_ERR("sensor: device not ready.");
+        return -ENODEV;
     }
 
-    // led_set_brightness(pwm_leds_dev, DISP_BL, 100);
+    if (als_start()) {
+        LOG_ERR("Failed to start ambient light sensing");
+        return -EIO;
+    }
 
-    while (1) {
+#ifdef ALS_USE_INT_GPIO
+    gpio_init_callback(&als_int_cb, als_int_handler, BIT(als_int.pin));
+    if (gpio_add_callback(als_int.port, &als_int_cb)) {
+        LOG_ERR("Failed to add the ambient light sensor interrupt callback");
+        return -EIO;
+    }
+#endif
 
-        k_msleep(NORMAL_SAMPLE_SLEEP_MS);
+    stats.since = k_uptime_get();
 
+    // The first reading is only valid after one integration cycle
+    k_work_schedule(&als_work, K_MSEC(NORMAL_SAMPLE_SLEEP_MS));
 
-        if (sensor_sample_fetch(dev)) {
-            LOG_ERR("sensor_sample fetch failed\n");
-        }
+    return 0;
+}
 
-        if (sensor_channel_get(dev, SENSOR_CHAN_LIGHT, &intensity)) {
-            LOG_ERR("Cannot read ALS data.\n");
-        }
+SYS_INIT(als_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+// Nothing reads the sensor while the display is off, so power its ALS engine
+// down as well instead of leaving it integrating
+static void als_suspend(void) {
+#ifdef ALS_USE_INT_GPIO
+    gpio_pin_interrupt_configure_dt(&als_int, GPIO_INT_DISABLE);
+#endif
+    k_work_cancel_delayable(&als_work);
+
+#ifdef CONFIG_PROSPECTOR_PROXIMITY_WAKE
+    als_suspended = true;
+    if (prox_arm()) {
+        LOG_ERR("Failed to arm proximity wake");
+    }
+#else
+    if (i2c_reg_update_byte_dt(&als_i2c, APDS9960_ENABLE_REG, ALS_ENABLE_BITS, 0)) {
+        LOG_ERR("Failed to stop ambient light sensing");
+    }
+#endif
+}
+
+static void als_resume(void) {
+#ifdef CONFIG_PROSPECTOR_PROXIMITY_WAKE
+    gpio_pin_interrupt_configure_dt(&als_int, GPIO_INT_DISABLE);
+    als_suspended = false;
+#endif
+
+    if (i2c_reg_update_byte_dt(&als_i2c, APDS9960_ENABLE_REG,
+                               ALS_ENABLE_BITS | APDS9960_ENABLE_PEN | APDS9960_ENABLE_PIEN,
+                               ALS_ENABLE_BITS)) {
+        LOG_ERR("Failed to restart ambient light sensing");
+        return;
+    }
+
+    // Keep the last brightness until a full integration cycle has completed
+    k_work_reschedule(&als_work, K_MSEC(NORMAL_SAMPLE_SLEEP_MS));
+}
+
+#endif // CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+
+static uint8_t brightness_target(void) {
+#ifdef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+    if (!brightness_settings.manual) {
+        return MIN(CLAMP(current_brightness + brightness_settings.offset, BRIGHTNESS_MIN,
+                         BRIGHTNESS_MAX),
+                   brightness_limit);
+    }
+#endif
+
+    return MIN(brightness_settings.level, brightness_limit);
+}
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+
+static uint32_t settings_writes;
+
+// Coalesce bursts of adjustments into a single flash write once they settle
+static void brightness_save_work_cb(struct k_work *work) {
+    int err = settings_save_one("prospector/brightness", &brightness_settings,
+                                sizeof(brightness_settings));
+    if (err) {
+        LOG_ERR("Failed to save brightness settings (err %d)", err);
+        return;
+    }
+
+    settings_writes++;
+    LOG_DBG("Saved brightness settings, %u flash writes so far", settings_writes);
+}
+
+static K_WORK_DELAYABLE_DEFINE(brightness_save_work, brightness_save_work_cb);
 
-        // LOG_INF("ambient light intensity %d", intensity.val1);
-
-        mapped_brightness = map_light_to_pwm(intensity.val1);
-        // LOG_INF("NORMAL: mapped PWM duty cycle %d\n", mapped_brightness);
-
-        if (abs(mapped_brightness - current_brightness) > FADE_THRESHOLD) {
-            uint8_t integrator = 0;
-
-            for (int i = 0; i < BURST_SAMPLE_TIMEOUT; i++) {
-                k_msleep(BURST_SAMPLE_SLEEP_MS);
-
-                if (sensor_sample_fetch(dev)) {
-                    LOG_ERR("sensor_sample fetch failed\n");
-                }
-                if (sensor_channel_get(dev, SENSOR_CHAN_LIGHT, &intensity)) {
-                    LOG_ERR("Cannot read ALS data.\n");
-                }
-
-                mapped_brightness = map_light_to_pwm(intensity.val1);
-                // LOG_INF("BURST: mapped PWM duty cycle %d\n", mapped_brightness);
-
-                if (abs(mapped_brightness - current_brightness) > FADE_THRESHOLD) {
-                    integrator++;
-                    // printk("integrator at: %d", integrator);
-                    if (integrator >= BURST_SAMPLE_CONSECUTIVE) {
-                        bl_fade(current_brightness, mapped_brightness);
-                        current_brightness = mapped_brightness;
-                        // LOG_INF("SETTING NEW BRIGHTNESS: %d", mapped_brightness);
-                        break;
-                    }
-                }
-            }
+static int brightness_settings_set(const char *name, size_t len, settings_read_cb read_cb,
+                                   void *cb_arg) {
+    const char *next;
+
+    if (settings_name_steq(name, "brightness", &next) && !next) {
+        if (len != sizeof(brightness_settings)) {
+            return -EINVAL;
         }
-        // led_set_brightness(pwm_leds_dev, DISP_BL, map_light_to_pwm(intensity.val1));
+
+        int rc = read_cb(cb_arg, &brightness_settings, sizeof(brightness_settings));
+        return MIN(rc, 0);
+    }
+
+    return -ENOENT;
+}
+
+static int brightness_settings_commit(void) {
+#ifndef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+    brightness_settings.manual = true;
+#endif
+    bl_fade_to(brightness_target());
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(prospector, "prospector", NULL, brightness_settings_set,
+                               brightness_settings_commit, NULL);
+
+#endif // IS_ENABLED(CONFIG_SETTINGS)
+
+static void brightness_update(void) {
+    bl_fade_to(brightness_target());
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+    k_work_reschedule(&brightness_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+#endif
+}
+
+int prospector_brightness_set(uint8_t level) {
+    if (level < BRIGHTNESS_MIN || level > BRIGHTNESS_MAX) {
+        return -EINVAL;
     }
+
+    brightness_settings.manual = true;
+    brightness_settings.level = level;
+    brightness_update();
+
+    return 0;
 }
 
-K_THREAD_DEFINE(als_tid, 1024, als_thread, NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0,
-                0);
+int prospector_brightness_set_auto(int8_t offset) {
+#ifdef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+    if (offset < -BRIGHTNESS_MAX || offset > BRIGHTNESS_MAX) {
+        return -EINVAL;
+    }
+
+    brightness_settings.manual = false;
+    brightness_settings.offset = offset;
+    brightness_update();
 
+    return 0;
 #else
+    return -ENOTSUP;
+#endif
+}
+
+int prospector_brightness_adjust(int8_t delta) {
+    if (brightness_settings.manual) {
+        return prospector_brightness_set(
+            CLAMP(brightness_settings.level + delta, BRIGHTNESS_MIN, BRIGHTNESS_MAX));
+    }
+
+    return prospector_brightness_set_auto(
+        CLAMP(brightness_settings.offset + delta, -BRIGHTNESS_MAX, BRIGHTNESS_MAX));
+}
+
+bool prospector_brightness_is_auto(void) { return !brightness_settings.manual; }
+
+uint8_t prospector_brightness_get_level(void) { return brightness_settings.level; }
+
+int8_t prospector_brightness_get_offset(void) { return brightness_settings.offset; }
+
+void prospector_brightness_set_limit(uint8_t limit) {
+    // Switching the backlight off or back on is immediate, dimming fades
+    bool instant = limit == 0 || brightness_limit == 0;
+
+    brightness_limit = MIN(limit, BRIGHTNESS_MAX);
+
+    if (instant) {
+        bl_set(brightness_target());
+    } else {
+        bl_fade_to(brightness_target());
+    }
+}
+
+void prospector_brightness_suspend(void) {
+#ifdef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+    als_suspend();
+#endif
+}
+
+void prospector_brightness_resume(void) {
+#ifdef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
+    als_resume();
+#endif
+}
+
+#ifndef CONFIG_PROSPECTOR_USE_AMBIENT_LIGHT_SENSOR
 
 static int init_fixed_brightness(void) {
-    led_set_brightness(pwm_leds_dev, DISP_BL, CONFIG_PROSPECTOR_FIXED_BRIGHTNESS);
+    return bl_set(brightness_target());
+}
+
+SYS_INIT(init_fixed_brightness, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+#endif
+
+#if IS_ENABLED(CONFIG_SHELL)
+
+static int cmd_brightness_get(const struct shell *sh, size_t argc, char **argv) {
+    if (prospector_brightness_is_auto()) {
+        shell_print(sh, "auto, offset %d, now %d", prospector_brightness_get_offset(), bl_get());
+    } else {
+        shell_print(sh, "fixed at %d", prospector_brightness_get_level());
+    }
 
     return 0;
 }
 
-SYS_INIT(init_fixed_brightness, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+static int cmd_brightness_set(const struct shell *sh, size_t argc, char **argv) {
+    long level = strtol(argv[1], NULL, 10);
+
+    int err = level < BRIGHTNESS_MIN || level > BRIGHTNESS_MAX ? -EINVAL
+                                                               : prospector_brightness_set(level);
+    if (err) {
+        shell_error(sh, "Brightness must be between %d and %d", BRIGHTNESS_MIN, BRIGHTNESS_MAX);
+    }
+
+    return err;
+}
+
+static int cmd_brightness_auto(const struct shell *sh, size_t argc, char **argv) {
+    long offset = argc > 1 ? strtol(argv[1], NULL, 10) : 0;
+
+    int err = offset < -BRIGHTNESS_MAX || offset > BRIGHTNESS_MAX
+                  ? -EINVAL
+                  : prospector_brightness_set_auto(offset);
+    if (err == -ENOTSUP) {
+        shell_error(sh, "Built without the ambient light sensor");
+    } else if (err) {
+        shell_error(sh, "Offset must be between %d and %d", -BRIGHTNESS_MAX, BRIGHTNESS_MAX);
+    }
+
+    return err;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_brightness, SHELL_CMD(get, NULL, "Show the display brightness setting", cmd_brightness_get),
+    SHELL_CMD_ARG(set, NULL, "Use a fixed brightness <1-100>", cmd_brightness_set, 2, 0),
+    SHELL_CMD_ARG(auto, NULL, "Follow ambient light [offset]", cmd_brightness_auto, 1, 1),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(brightness, &sub_brightness, "Display brightness", NULL);
 
-#endif
\ No newline at end of file
+#endif // IS_ENABLED(CONFIG_SHELL)
@@ -6,7 +6,10 @@
 #include "widgets/layer_roller.h"
 #include "widgets/battery_bar.h"
 #include "widgets/caps_word_indicator.h"
+#include "widgets/latency_stats.h"
+#include "widgets/lock_indicators.h"
 
+#include <display_power.h>
 #include <fonts.h>
 #include <sf_symbols.h>
 
@@ -18,6 +21,12 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 static struct zmk_widget_layer_roller layer_roller_widget;
 static struct zmk_widget_battery_bar battery_bar_widget;
 static struct zmk_widget_caps_word_indicator caps_word_indicator_widget;
+#if IS_ENABLED(CONFIG_PROSPECTOR_KEYSTROKE_LATENCY_WIDGET)
+static struct zmk_widget_latency_stats latency_stats_widget;
+#endif
+#if IS_ENABLED(CONFIG_PROSPECTOR_LOCK_INDICATORS)
+static struct zmk_widget_lock_indicators lock_indicators_widget;
+#endif
 
 lv_obj_t *zmk_display_status_screen() {
     lv_obj_t *screen;
@@ -25,11 +34,25 @@ lv_obj_t *zmk_display_status_screen() {
     lv_obj_set_style_bg_color(screen, lv_color_hex(0x000000), LV_PART_MAIN);
     lv_obj_set_style_bg_opa(screen, 255, LV_PART_MAIN);
 
+#if IS_ENABLED(CONFIG_PROSPECTOR_DISPLAY_POWER)
+    display_power_monitor(lv_disp_get_default());
+#endif
+
 #ifdef CONFIG_DT_HAS_ZMK_BEHAVIOR_CAPS_WORD_ENABLED
     zmk_widget_caps_word_indicator_init(&caps_word_indicator_widget, screen);
     lv_obj_align(zmk_widget_caps_word_indicator_obj(&caps_word_indicator_widget), LV_ALIGN_RIGHT_MID, -10, 46);
 #endif
 
+#if IS_ENABLED(CONFIG_PROSPECTOR_LOCK_INDICATORS)
+    zmk_widget_lock_indicators_init(&lock_indicators_widget, screen);
+    lv_obj_align(zmk_widget_lock_indicators_obj(&lock_indicators_widget), LV_ALIGN_RIGHT_MID, -10, -30);
+#endif
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_KEYSTROKE_LATENCY_WIDGET)
+    zmk_widget_latency_stats_init(&latency_stats_widget, screen);
+    lv_obj_align(zmk_widget_latency_stats_obj(&latency_stats_widget), LV_ALIGN_TOP_RIGHT, -10, 10);
+#endif
+
     zmk_widget_battery_bar_init(&battery_bar_widget, screen);
     // lv_obj_set_width(zmk_widget_battery_bar_obj(&battery_bar_widget), lv_pct(100));
     lv_obj_set_size(zmk_widget_battery_bar_obj(&battery_bar_widget), lv_pct(100), 48);
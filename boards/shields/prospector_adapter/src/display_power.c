@@ -0,0 +1,257 @@
+#include <zephyr/device.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <lvgl.h>
+
+#include <zmk/activity.h>
+#include <zmk/display.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
+#include <zmk/events/position_state_changed.h>
+
+#include <display_power.h>
+#include <prospector/brightness.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// The panel itself is blanked and LVGL's refresh timer stopped by ZMK's
+// CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE handling, this takes care of everything
+// ZMK does not know about: the dim stage, the backlight and the ALS controller
+enum display_power_state {
+    DISPLAY_POWER_ON,
+    DISPLAY_POWER_DIM,
+    DISPLAY_POWER_OFF,
+};
+
+static const char *const state_names[] = {"on", "dim", "off"};
+
+static atomic_t state = ATOMIC_INIT(DISPLAY_POWER_ON);
+
+// Cycle count of the keypress or proximity reading that requested a wake, 0
+// when none is pending
+static atomic_t wake_requested_at;
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_PROXIMITY_WAKE)
+// Uptime of the last proximity wake that no keypress has followed yet, 0 when
+// there is none
+static atomic_t prewake_at;
+#endif
+
+// Frames rendered and pixels sent over SPI in the current state, as proxies
+// for CPU wakeups and bus traffic
+struct display_power_stats {
+    atomic_t refreshes;
+    atomic_t flushed_px;
+    int64_t since;
+};
+
+static struct display_power_stats stats;
+
+static void display_power_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px) {
+    atomic_inc(&stats.refreshes);
+    atomic_add(&stats.flushed_px, px);
+}
+
+void display_power_monitor(lv_disp_t *disp) { disp->driver->monitor_cb = display_power_monitor_cb; }
+
+static void display_power_enter(enum display_power_state next) {
+    enum display_power_state prev = atomic_get(&state);
+    if (next == prev) {
+        return;
+    }
+
+    int64_t now = k_uptime_get();
+    LOG_INF("Display %s for %d ms: %d frames, %d bytes over SPI", state_names[prev],
+            (int)(now - stats.since), (int)atomic_set(&stats.refreshes, 0),
+            (int)atomic_set(&stats.flushed_px, 0) * (LV_COLOR_DEPTH / 8));
+    stats.since = now;
+
+    switch (next) {
+    case DISPLAY_POWER_ON:
+        prospector_brightness_set_limit(100);
+        if (prev == DISPLAY_POWER_OFF) {
+            prospector_brightness_resume();
+        }
+        break;
+    case DISPLAY_POWER_DIM:
+        prospector_brightness_set_limit(CONFIG_PROSPECTOR_DISPLAY_DIM_BRIGHTNESS);
+        break;
+    case DISPLAY_POWER_OFF:
+        prospector_brightness_suspend();
+        prospector_brightness_set_limit(0);
+        break;
+    }
+
+    atomic_set(&state, next);
+}
+
+static void display_power_dim_cb(struct k_work *work) {
+    if (atomic_get(&state) == DISPLAY_POWER_ON) {
+        display_power_enter(DISPLAY_POWER_DIM);
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(dim_work, display_power_dim_cb);
+
+static void display_power_off_cb(struct k_work *work) {
+    k_work_cancel_delayable(&dim_work);
+    display_power_enter(DISPLAY_POWER_OFF);
+}
+
+static K_WORK_DEFINE(off_work, display_power_off_cb);
+
+// Queued behind ZMK's own unblank on the display work queue, so this runs
+// once LVGL is free to push the next frame
+static void display_power_panel_cb(struct k_work *work) {
+    uint32_t requested = atomic_set(&wake_requested_at, 0);
+    if (requested) {
+        LOG_DBG("Display ready %u us after wake request",
+                k_cyc_to_us_floor32(k_cycle_get_32() - requested));
+    }
+}
+
+static K_WORK_DEFINE(panel_work, display_power_panel_cb);
+
+static void display_power_wake_cb(struct k_work *work) {
+    display_power_enter(DISPLAY_POWER_ON);
+
+    uint32_t requested = atomic_get(&wake_requested_at);
+    if (requested) {
+        LOG_DBG("Backlight restored %u us after wake request",
+                k_cyc_to_us_floor32(k_cycle_get_32() - requested));
+    }
+
+    k_work_submit_to_queue(zmk_display_work_q(), &panel_work);
+}
+
+static K_WORK_DEFINE(wake_work, display_power_wake_cb);
+
+static void display_power_wake(void) {
+    if (atomic_get(&state) != DISPLAY_POWER_ON) {
+        uint32_t now = k_cycle_get_32();
+        atomic_cas(&wake_requested_at, 0, now ? now : 1);
+        k_work_submit(&wake_work);
+    }
+
+    k_work_reschedule(&dim_work, K_MSEC(CONFIG_PROSPECTOR_DISPLAY_DIM_TIMEOUT));
+}
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_PROXIMITY_WAKE)
+
+// ZMK only unblanks the panel and restarts LVGL on its own activity changes,
+// so a proximity wake drives the panel directly and leaves ZMK's activity
+// state alone. A keypress hands the panel back to ZMK, otherwise it is
+// blanked again after the timeout.
+#if IS_ENABLED(CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE)
+static const struct device *const display_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_display));
+
+// Stands in for ZMK's stopped refresh timer while the panel is prewoken
+static void display_power_prewake_refresh_cb(struct k_work *work) {
+    lv_task_handler();
+
+    if (atomic_get(&prewake_at)) {
+        k_work_schedule_for_queue(zmk_display_work_q(), k_work_delayable_from_work(work),
+                                  K_MSEC(CONFIG_LV_DISP_DEF_REFR_PERIOD));
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(prewake_refresh_work, display_power_prewake_refresh_cb);
+
+static void display_power_prewake_panel_on_cb(struct k_work *work) {
+    display_blanking_off(display_dev);
+    k_work_reschedule_for_queue(zmk_display_work_q(), &prewake_refresh_work, K_NO_WAIT);
+}
+
+static K_WORK_DEFINE(prewake_panel_on_work, display_power_prewake_panel_on_cb);
+
+static void display_power_prewake_panel_off_cb(struct k_work *work) {
+    k_work_cancel_delayable(&prewake_refresh_work);
+    display_blanking_on(display_dev);
+}
+
+static K_WORK_DEFINE(prewake_panel_off_work, display_power_prewake_panel_off_cb);
+#endif
+
+static void display_power_prewake_timeout_cb(struct k_work *work) {
+    // Some other input may have woken ZMK meanwhile, which then owns the panel
+    if (!atomic_set(&prewake_at, 0) || zmk_activity_get_state() == ZMK_ACTIVITY_ACTIVE) {
+        return;
+    }
+
+    LOG_DBG("No keypress after proximity wake, turning the display off again");
+    k_work_submit(&off_work);
+#if IS_ENABLED(CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE)
+    k_work_submit_to_queue(zmk_display_work_q(), &prewake_panel_off_work);
+#endif
+}
+
+static K_WORK_DELAYABLE_DEFINE(prewake_timeout_work, display_power_prewake_timeout_cb);
+
+void display_power_prewake(void) {
+    if (atomic_get(&state) != DISPLAY_POWER_OFF) {
+        return;
+    }
+
+    atomic_set(&prewake_at, k_uptime_get_32());
+    display_power_wake();
+#if IS_ENABLED(CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE)
+    k_work_submit_to_queue(zmk_display_work_q(), &prewake_panel_on_work);
+#endif
+    k_work_schedule(&prewake_timeout_work, K_MSEC(CONFIG_PROSPECTOR_PROXIMITY_WAKE_TIMEOUT));
+}
+
+static void display_power_prewake_keypress(void) {
+    uint32_t prewake = atomic_set(&prewake_at, 0);
+    if (prewake) {
+        k_work_cancel_delayable(&prewake_timeout_work);
+#if IS_ENABLED(CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE)
+        k_work_cancel_delayable(&prewake_refresh_work);
+#endif
+        LOG_DBG("Keypress %u ms after proximity wake, display was already on",
+                k_uptime_get_32() - prewake);
+    }
+}
+
+#endif // IS_ENABLED(CONFIG_PROSPECTOR_PROXIMITY_WAKE)
+
+static int display_power_listener(const zmk_event_t *eh) {
+    const struct zmk_position_state_changed *pos = as_zmk_position_state_changed(eh);
+    if (pos != NULL) {
+        if (pos->state) {
+#if IS_ENABLED(CONFIG_PROSPECTOR_PROXIMITY_WAKE)
+            display_power_prewake_keypress();
+#endif
+            display_power_wake();
+        }
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    const struct zmk_activity_state_changed *activity = as_zmk_activity_state_changed(eh);
+    if (activity != NULL) {
+        switch (activity->state) {
+        case ZMK_ACTIVITY_ACTIVE:
+            display_power_wake();
+            break;
+        case ZMK_ACTIVITY_IDLE:
+        case ZMK_ACTIVITY_SLEEP:
+            k_work_submit(&off_work);
+            break;
+        }
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(display_power, display_power_listener);
+ZMK_SUBSCRIPTION(display_power, zmk_position_state_changed);
+ZMK_SUBSCRIPTION(display_power, zmk_activity_state_changed);
+
+static int display_power_init(void) {
+    stats.since = k_uptime_get();
+    k_work_schedule(&dim_work, K_MSEC(CONFIG_PROSPECTOR_DISPLAY_DIM_TIMEOUT));
+    return 0;
+}
+
+SYS_INIT(display_power_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
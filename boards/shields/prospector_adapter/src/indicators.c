@@ -0,0 +1,169 @@
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+
+#include <zmk/display.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/battery_state_changed.h>
+#include <zmk/events/split_central_status_changed.h>
+#ifdef CONFIG_DT_HAS_ZMK_BEHAVIOR_CAPS_WORD_ENABLED
+#include <zmk/events/caps_word_state_changed.h>
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
+#include <zmk/events/hid_indicators_changed.h>
+#endif
+
+#include <indicators.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+BUILD_ASSERT(INDICATOR_BIT_COUNT <= 32, "Indicator snapshot supports up to 14 peripherals");
+
+// One listener keeps the snapshot for every widget. Events that don't change
+// anything are dropped here, the rest set their bits in `changed` and share a
+// single render pass on the display work queue.
+static struct k_spinlock lock;
+static struct indicator_state snapshot;
+static uint32_t changed;
+// Bits that received a value since boot, replayed to new subscribers
+static uint32_t valid;
+
+static sys_slist_t subscribers = SYS_SLIST_STATIC_INIT(&subscribers);
+
+static struct {
+    atomic_t received;
+    atomic_t dropped;
+    atomic_t batches;
+} stats;
+
+static void indicators_work_cb(struct k_work *work) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    struct indicator_state state = snapshot;
+    uint32_t pending = changed;
+    changed = 0;
+    k_spin_unlock(&lock, key);
+
+    if (pending == 0) {
+        return;
+    }
+
+    atomic_inc(&stats.batches);
+    LOG_DBG("Indicators 0x%08x changed: %d events, %d unchanged, %d batches", pending,
+            (int)atomic_get(&stats.received), (int)atomic_get(&stats.dropped),
+            (int)atomic_get(&stats.batches));
+
+    struct indicator_subscriber *sub;
+    SYS_SLIST_FOR_EACH_CONTAINER(&subscribers, sub, node) {
+        if (sub->mask & pending) {
+            sub->cb(&state, sub->mask & pending);
+        }
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(indicators_work, indicators_work_cb);
+
+// Both setters return whether the snapshot changed, a bit's first value
+// always counts as a change
+static bool indicators_set_flag(uint8_t bit, bool value) {
+    uint32_t flags = value ? (snapshot.flags | BIT(bit)) : (snapshot.flags & ~BIT(bit));
+    if (flags == snapshot.flags && (valid & BIT(bit))) {
+        return false;
+    }
+
+    snapshot.flags = flags;
+    changed |= BIT(bit);
+    valid |= BIT(bit);
+    return true;
+}
+
+static bool indicators_set_battery(uint8_t slot, uint8_t level) {
+    uint8_t bit = INDICATOR_BATTERY_BASE + slot;
+    if (snapshot.battery[slot] == level && (valid & BIT(bit))) {
+        return false;
+    }
+
+    snapshot.battery[slot] = level;
+    changed |= BIT(bit);
+    valid |= BIT(bit);
+    return true;
+}
+
+static int indicators_listener(const zmk_event_t *eh) {
+    atomic_inc(&stats.received);
+
+    bool dirty = false;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+#ifdef CONFIG_DT_HAS_ZMK_BEHAVIOR_CAPS_WORD_ENABLED
+    const struct zmk_caps_word_state_changed *caps = as_zmk_caps_word_state_changed(eh);
+    if (caps != NULL) {
+        dirty = indicators_set_flag(INDICATOR_CAPS_WORD, caps->active);
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
+    // Bits of the HID keyboard LED output report
+    const struct zmk_hid_indicators_changed *leds = as_zmk_hid_indicators_changed(eh);
+    if (leds != NULL) {
+        dirty |= indicators_set_flag(INDICATOR_NUM_LOCK, leds->indicators & BIT(0));
+        dirty |= indicators_set_flag(INDICATOR_CAPS_LOCK, leds->indicators & BIT(1));
+        dirty |= indicators_set_flag(INDICATOR_SCROLL_LOCK, leds->indicators & BIT(2));
+    }
+#endif
+
+    const struct zmk_split_central_status_changed *conn = as_zmk_split_central_status_changed(eh);
+    if (conn != NULL && conn->slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+        dirty = indicators_set_flag(INDICATOR_CONNECTED_BASE + conn->slot, conn->connected);
+    }
+
+    const struct zmk_peripheral_battery_state_changed *bat =
+        as_zmk_peripheral_battery_state_changed(eh);
+    if (bat != NULL && bat->source < ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+        dirty = indicators_set_battery(bat->source, bat->state_of_charge);
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (!dirty) {
+        atomic_inc(&stats.dropped);
+    } else if (zmk_display_is_initialized()) {
+        k_work_schedule_for_queue(zmk_display_work_q(), &indicators_work,
+                                  K_MSEC(CONFIG_LV_DISP_DEF_REFR_PERIOD));
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(indicators, indicators_listener);
+#ifdef CONFIG_DT_HAS_ZMK_BEHAVIOR_CAPS_WORD_ENABLED
+ZMK_SUBSCRIPTION(indicators, zmk_caps_word_state_changed);
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
+ZMK_SUBSCRIPTION(indicators, zmk_hid_indicators_changed);
+#endif
+ZMK_SUBSCRIPTION(indicators, zmk_split_central_status_changed);
+ZMK_SUBSCRIPTION(indicators, zmk_peripheral_battery_state_changed);
+
+void indicators_subscribe(struct indicator_subscriber *sub) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    struct indicator_state state = snapshot;
+    uint32_t known = valid & sub->mask;
+    k_spin_unlock(&lock, key);
+
+    sys_snode_t *prev;
+    if (!sys_slist_find(&subscribers, &sub->node, &prev)) {
+        sys_slist_append(&subscribers, &sub->node);
+    }
+
+    if (known) {
+        sub->cb(&state, known);
+    }
+
+    // The listener leaves changes to pile up until the display is initialized,
+    // and the widgets subscribe while it is being initialized. This render pass
+    // runs once that is done and flushes whatever arrived in between, which no
+    // later event might come along to schedule.
+    k_work_schedule_for_queue(zmk_display_work_q(), &indicators_work,
+                              K_MSEC(CONFIG_LV_DISP_DEF_REFR_PERIOD));
+}
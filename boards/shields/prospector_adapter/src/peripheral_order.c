@@ -0,0 +1,193 @@
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <string.h>
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+#include <zephyr/settings/settings.h>
+#endif
+
+#include <zmk/ble.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/split_central_status_changed.h>
+
+#include <peripheral_order.h>
+
+#include "widgets/battery_bar.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// ZMK numbers key positions row by row from the left edge of the keyboard, so
+// the half whose lowest key position is smaller sits further left. The lowest
+// position seen is remembered per peer address, which keeps every half in its
+// place across reconnects no matter in which order the halves were paired.
+struct peripheral_order_entry {
+    uint32_t addr_hash;
+    uint32_t min_position;
+};
+
+#define PERIPHERAL_ORDER_ENTRIES (2 * ZMK_SPLIT_BLE_PERIPHERAL_COUNT)
+#define POSITION_UNKNOWN UINT32_MAX
+
+static struct peripheral_order_entry entries[PERIPHERAL_ORDER_ENTRIES];
+static uint32_t slot_addr_hash[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+static uint8_t slot_position[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+
+static bool peripheral_order_hash_in_use(uint32_t addr_hash) {
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        if (slot_addr_hash[i] == addr_hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find the entry for addr_hash, reusing the first empty entry or one that no
+// current slot refers to when it is new
+static struct peripheral_order_entry *peripheral_order_entry_for(uint32_t addr_hash) {
+    struct peripheral_order_entry *spare = NULL;
+
+    for (int i = 0; i < PERIPHERAL_ORDER_ENTRIES; i++) {
+        if (entries[i].addr_hash == addr_hash) {
+            return &entries[i];
+        }
+        if (spare == NULL && (entries[i].addr_hash == 0 ||
+                              !peripheral_order_hash_in_use(entries[i].addr_hash))) {
+            spare = &entries[i];
+        }
+    }
+
+    if (spare != NULL) {
+        *spare = (struct peripheral_order_entry){
+            .addr_hash = addr_hash,
+            .min_position = POSITION_UNKNOWN,
+        };
+    }
+
+    return spare;
+}
+
+static uint32_t peripheral_order_key(uint8_t slot) {
+    if (slot_addr_hash[slot] == 0) {
+        return POSITION_UNKNOWN;
+    }
+
+    struct peripheral_order_entry *entry = peripheral_order_entry_for(slot_addr_hash[slot]);
+    return entry != NULL ? entry->min_position : POSITION_UNKNOWN;
+}
+
+// Rank the slots by their lowest key position, leaving the current order alone
+// until every peripheral seen so far has a position to compare
+static void peripheral_order_update(void) {
+    uint32_t keys[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+    uint8_t position[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+
+    for (uint8_t slot = 0; slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; slot++) {
+        keys[slot] = peripheral_order_key(slot);
+        if (slot_addr_hash[slot] != 0 && keys[slot] == POSITION_UNKNOWN) {
+            return;
+        }
+    }
+
+    for (uint8_t slot = 0; slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; slot++) {
+        position[slot] = 0;
+        for (uint8_t other = 0; other < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; other++) {
+            if (keys[other] < keys[slot] || (keys[other] == keys[slot] && other < slot)) {
+                position[slot]++;
+            }
+        }
+    }
+
+    if (memcmp(position, slot_position, sizeof(position)) == 0) {
+        return;
+    }
+
+    memcpy(slot_position, position, sizeof(position));
+    LOG_DBG("Peripheral order changed");
+    zmk_widget_battery_bar_order_changed();
+}
+
+uint8_t peripheral_order_position(uint8_t slot) {
+    return slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT ? slot_position[slot] : slot;
+}
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+
+static void peripheral_order_save_work_cb(struct k_work *work) {
+    int err = settings_save_one("prospector/split/order", entries, sizeof(entries));
+    if (err) {
+        LOG_ERR("Failed to save peripheral order (err %d)", err);
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(peripheral_order_save_work, peripheral_order_save_work_cb);
+
+static int peripheral_order_settings_set(const char *name, size_t len, settings_read_cb read_cb,
+                                         void *cb_arg) {
+    const char *next;
+
+    if (settings_name_steq(name, "order", &next) && !next) {
+        if (len != sizeof(entries)) {
+            return -EINVAL;
+        }
+
+        int rc = read_cb(cb_arg, entries, sizeof(entries));
+        return MIN(rc, 0);
+    }
+
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(prospector_split, "prospector/split", NULL,
+                               peripheral_order_settings_set, NULL, NULL);
+
+#endif // IS_ENABLED(CONFIG_SETTINGS)
+
+static int peripheral_order_listener(const zmk_event_t *eh) {
+    const struct zmk_split_central_status_changed *status =
+        as_zmk_split_central_status_changed(eh);
+    if (status != NULL) {
+        if (status->connected && status->slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+            slot_addr_hash[status->slot] = status->addr_hash;
+            peripheral_order_update();
+        }
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    const struct zmk_position_state_changed *pos = as_zmk_position_state_changed(eh);
+    if (pos == NULL || !pos->state || pos->source >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT ||
+        slot_addr_hash[pos->source] == 0) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    struct peripheral_order_entry *entry =
+        peripheral_order_entry_for(slot_addr_hash[pos->source]);
+    if (entry == NULL || pos->position >= entry->min_position) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    entry->min_position = pos->position;
+    peripheral_order_update();
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+    k_work_reschedule(&peripheral_order_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+#endif
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(peripheral_order, peripheral_order_listener);
+ZMK_SUBSCRIPTION(peripheral_order, zmk_split_central_status_changed);
+ZMK_SUBSCRIPTION(peripheral_order, zmk_position_state_changed);
+
+static int peripheral_order_init(void) {
+    // Pairing order until the halves have been told apart
+    for (uint8_t slot = 0; slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; slot++) {
+        slot_position[slot] = slot;
+    }
+
+    return 0;
+}
+
+SYS_INIT(peripheral_order_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
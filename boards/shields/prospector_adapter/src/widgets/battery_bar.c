@@ -3,11 +3,10 @@
 #include <zmk/display.h>
 #include <zmk/battery.h>
 #include <zmk/ble.h>
-#include <zmk/events/battery_state_changed.h>
-#include <zmk/events/split_central_status_changed.h>
-#include <zmk/event_manager.h>
 
 #include <fonts.h>
+#include <indicators.h>
+#include <peripheral_order.h>
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -16,117 +15,149 @@ static sys_slist_t widgets = SYS_SLIST_STATIC_INIT(&widgets);
 
 bool initialized = false;
 
-// Simplified state structures for each event type
-struct battery_update_state {
-    uint8_t source;
-    uint8_t level;
-};
+// Shared styles for the normal and low battery states, swapped only when the
+// level crosses BATTERY_LOW_THRESHOLD so regular updates don't restyle the bar
+#define BATTERY_LOW_THRESHOLD 20
+
+static lv_style_t style_bar_main_normal;
+static lv_style_t style_bar_main_low;
+static lv_style_t style_bar_indicator_normal;
+static lv_style_t style_bar_indicator_low;
+static lv_style_t style_num_normal;
+static lv_style_t style_num_low;
+
+static void battery_bar_styles_init(void) {
+    static bool styles_initialized = false;
+    if (styles_initialized) {
+        return;
+    }
 
-struct connection_update_state {
-    uint8_t source;
-    bool connected;
-};
+    lv_style_init(&style_bar_main_normal);
+    lv_style_set_bg_color(&style_bar_main_normal, lv_color_hex(0x202020));
 
-static void set_battery_bar_value(lv_obj_t *widget, struct battery_update_state state) {
-    if (initialized) {
-        lv_obj_t *info_container = lv_obj_get_child(widget, state.source);
-        lv_obj_t *bar = lv_obj_get_child(info_container, 0);
-        lv_obj_t *num = lv_obj_get_child(info_container, 1);
-
-        lv_bar_set_value(bar, state.level, LV_ANIM_ON);
-        lv_label_set_text_fmt(num, "%d", state.level);
-
-        if (state.level < 20) {
-            lv_obj_set_style_bg_color(bar, lv_color_hex(0xD3900F), LV_PART_INDICATOR);
-            lv_obj_set_style_bg_grad_color(bar, lv_color_hex(0xE8AC11), LV_PART_INDICATOR);
-            lv_obj_set_style_bg_color(bar, lv_color_hex(0x6E4E07), LV_PART_MAIN);
-            lv_obj_set_style_text_color(num, lv_color_hex(0xFFB802), 0);
-        } else {
-            lv_obj_set_style_bg_color(bar, lv_color_hex(0x909090), LV_PART_INDICATOR);
-            lv_obj_set_style_bg_grad_color(bar, lv_color_hex(0xf0f0f0), LV_PART_INDICATOR);
-            lv_obj_set_style_bg_color(bar, lv_color_hex(0x202020), LV_PART_MAIN);
-            lv_obj_set_style_text_color(num, lv_color_hex(0xFFFFFF), 0);
-        }
-    }
+    lv_style_init(&style_bar_main_low);
+    lv_style_set_bg_color(&style_bar_main_low, lv_color_hex(0x6E4E07));
+
+    lv_style_init(&style_bar_indicator_normal);
+    lv_style_set_bg_color(&style_bar_indicator_normal, lv_color_hex(0x909090));
+    lv_style_set_bg_grad_color(&style_bar_indicator_normal, lv_color_hex(0xf0f0f0));
+
+    lv_style_init(&style_bar_indicator_low);
+    lv_style_set_bg_color(&style_bar_indicator_low, lv_color_hex(0xD3900F));
+    lv_style_set_bg_grad_color(&style_bar_indicator_low, lv_color_hex(0xE8AC11));
+
+    lv_style_init(&style_num_normal);
+    lv_style_set_text_color(&style_num_normal, lv_color_hex(0xFFFFFF));
+
+    lv_style_init(&style_num_low);
+    lv_style_set_text_color(&style_num_low, lv_color_hex(0xFFB802));
+
+    styles_initialized = true;
 }
 
-static void set_battery_bar_connected(lv_obj_t *widget, struct connection_update_state state) {
-    if (initialized) {
-        lv_obj_t *info_container = lv_obj_get_child(widget, state.source);
-        lv_obj_t *bar = lv_obj_get_child(info_container, 0);
-        lv_obj_t *num = lv_obj_get_child(info_container, 1);
-        lv_obj_t *nc_bar = lv_obj_get_child(info_container, 2);
-        lv_obj_t *nc_num = lv_obj_get_child(info_container, 3);
-
-        LOG_DBG("Peripheral %d %s", state.source,
-                state.connected ? "connected" : "disconnected");
-
-        if (state.connected) {
-            lv_obj_fade_out(nc_bar, 150, 0);
-            lv_obj_fade_out(nc_num, 150, 0);
-            lv_obj_fade_in(bar, 150, 250);
-            lv_obj_fade_in(num, 150, 250);
-        } else {
-            lv_obj_fade_out(bar, 150, 0);
-            lv_obj_fade_out(num, 150, 0);
-            lv_obj_fade_in(nc_bar, 150, 250);
-            lv_obj_fade_in(nc_num, 150, 250);
-        }
-    }
+static void battery_bar_set_low_style(lv_obj_t *bar, lv_obj_t *num, bool low) {
+    lv_obj_remove_style(bar, low ? &style_bar_main_normal : &style_bar_main_low, LV_PART_MAIN);
+    lv_obj_remove_style(bar, low ? &style_bar_indicator_normal : &style_bar_indicator_low,
+                        LV_PART_INDICATOR);
+    lv_obj_remove_style(num, low ? &style_num_normal : &style_num_low, 0);
+
+    lv_obj_add_style(bar, low ? &style_bar_main_low : &style_bar_main_normal, LV_PART_MAIN);
+    lv_obj_add_style(bar, low ? &style_bar_indicator_low : &style_bar_indicator_normal,
+                     LV_PART_INDICATOR);
+    lv_obj_add_style(num, low ? &style_num_low : &style_num_normal, 0);
 }
 
-// Battery event handling
-void battery_bar_battery_update_cb(struct battery_update_state state) {
-    LOG_DBG("Battery update: source=%d, level=%d", state.source, state.level);
+static void set_battery_bar_value(struct zmk_widget_battery_bar *widget, uint8_t source,
+                                  uint8_t level) {
+    if (!initialized || source >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+        return;
+    }
 
-    struct zmk_widget_battery_bar *widget;
-    SYS_SLIST_FOR_EACH_CONTAINER(&widgets, widget, node) {
-        set_battery_bar_value(widget->obj, state);
+    struct zmk_widget_battery_bar_peripheral *p = &widget->peripherals[source];
+
+    lv_bar_set_value(p->bar, level, LV_ANIM_ON);
+    lv_label_set_text_fmt(p->num, "%d", level);
+
+    bool low = level < BATTERY_LOW_THRESHOLD;
+    if (low != p->low) {
+        p->low = low;
+        battery_bar_set_low_style(p->bar, p->num, low);
+
+        LOG_DBG("Peripheral %d restyled %s, invalidated %d px", source,
+                low ? "low" : "normal",
+                lv_area_get_size(&p->bar->coords) + lv_area_get_size(&p->num->coords));
     }
 }
 
-static struct battery_update_state battery_bar_get_battery_state(const zmk_event_t *eh) {
-    const struct zmk_peripheral_battery_state_changed *bat_ev =
-        as_zmk_peripheral_battery_state_changed(eh);
+static void set_battery_bar_connected(struct zmk_widget_battery_bar *widget, uint8_t source,
+                                      bool connected) {
+    if (!initialized || source >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+        return;
+    }
+
+    struct zmk_widget_battery_bar_peripheral *p = &widget->peripherals[source];
 
-    LOG_DBG("Received battery event: source=%d, level=%d", bat_ev->source, bat_ev->state_of_charge);
+    LOG_DBG("Peripheral %d %s", source, connected ? "connected" : "disconnected");
 
-    return (struct battery_update_state){
-        .source = bat_ev->source,
-        .level = bat_ev->state_of_charge,
-    };
+    if (connected) {
+        lv_obj_fade_out(p->nc_bar, 150, 0);
+        lv_obj_fade_out(p->nc_num, 150, 0);
+        lv_obj_fade_in(p->bar, 150, 250);
+        lv_obj_fade_in(p->num, 150, 250);
+    } else {
+        lv_obj_fade_out(p->bar, 150, 0);
+        lv_obj_fade_out(p->num, 150, 0);
+        lv_obj_fade_in(p->nc_bar, 150, 250);
+        lv_obj_fade_in(p->nc_num, 150, 250);
+    }
 }
 
-// Connection event handling
-void battery_bar_connection_update_cb(struct connection_update_state state) {
-    LOG_DBG("Connection update: source=%d, connected=%s", state.source, state.connected ? "true" : "false");
-
+// Battery and connection changes of every peripheral arrive together, once
+// per frame
+static void battery_bar_indicators_cb(const struct indicator_state *state, uint32_t changed) {
     struct zmk_widget_battery_bar *widget;
     SYS_SLIST_FOR_EACH_CONTAINER(&widgets, widget, node) {
-        set_battery_bar_connected(widget->obj, state);
+        for (uint8_t i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+            if (changed & BIT(INDICATOR_CONNECTED_BASE + i)) {
+                bool connected = state->flags & BIT(INDICATOR_CONNECTED_BASE + i);
+                LOG_DBG("Connection update: source=%d, connected=%s", i,
+                        connected ? "true" : "false");
+                set_battery_bar_connected(widget, i, connected);
+            }
+            if (changed & BIT(INDICATOR_BATTERY_BASE + i)) {
+                LOG_DBG("Battery update: source=%d, level=%d", i, state->battery[i]);
+                set_battery_bar_value(widget, i, state->battery[i]);
+            }
+        }
     }
 }
 
-static struct connection_update_state battery_bar_get_connection_state(const zmk_event_t *eh) {
-    const struct zmk_split_central_status_changed *conn_ev =
-        as_zmk_split_central_status_changed(eh);
+static struct indicator_subscriber battery_bar_subscriber = {
+    .mask = INDICATOR_CONNECTED_MASK | INDICATOR_BATTERY_MASK,
+    .cb = battery_bar_indicators_cb,
+};
 
-    LOG_DBG("Received connection event: slot=%d, connected=%s", conn_ev->slot, conn_ev->connected ? "true" : "false");
+static void battery_bar_apply_order(struct zmk_widget_battery_bar *widget) {
+    // Place positions left to right so each move lands on its final index
+    for (uint8_t pos = 0; pos < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; pos++) {
+        for (uint8_t i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+            if (peripheral_order_position(i) == pos) {
+                lv_obj_move_to_index(widget->peripherals[i].container, pos);
+            }
+        }
+    }
+}
 
-    return (struct connection_update_state){
-        .source = conn_ev->slot,
-        .connected = conn_ev->connected,
-    };
+static void battery_bar_order_work_cb(struct k_work *work) {
+    struct zmk_widget_battery_bar *widget;
+    SYS_SLIST_FOR_EACH_CONTAINER(&widgets, widget, node) { battery_bar_apply_order(widget); }
 }
 
-// Separate widget listeners for each event type
-ZMK_DISPLAY_WIDGET_LISTENER(widget_battery_bar_battery, struct battery_update_state,
-                            battery_bar_battery_update_cb, battery_bar_get_battery_state);
-ZMK_SUBSCRIPTION(widget_battery_bar_battery, zmk_peripheral_battery_state_changed);
+static K_WORK_DEFINE(battery_bar_order_work, battery_bar_order_work_cb);
 
-ZMK_DISPLAY_WIDGET_LISTENER(widget_battery_bar_connection, struct connection_update_state,
-                            battery_bar_connection_update_cb, battery_bar_get_connection_state);
-ZMK_SUBSCRIPTION(widget_battery_bar_connection, zmk_split_central_status_changed);
+void zmk_widget_battery_bar_order_changed(void) {
+    k_work_submit_to_queue(zmk_display_work_q(), &battery_bar_order_work);
+}
 
 int zmk_widget_battery_bar_init(struct zmk_widget_battery_bar *widget, lv_obj_t *parent) {
     widget->obj = lv_obj_create(parent);
@@ -145,6 +176,8 @@ int zmk_widget_battery_bar_init(struct zmk_widget_battery_bar *widget, lv_obj_t
 
     // lv_obj_add_flag(widget->obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE);
 
+    battery_bar_styles_init();
+
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
         lv_obj_t *info_container = lv_obj_create(widget->obj);
         lv_obj_center(info_container);
@@ -154,12 +187,11 @@ int zmk_widget_battery_bar_init(struct zmk_widget_battery_bar *widget, lv_obj_t
         lv_obj_t *bar = lv_bar_create(info_container);
         lv_obj_set_size(bar, lv_pct(100), 4);
         lv_obj_align(bar, LV_ALIGN_BOTTOM_MID, 0, 0);
-        lv_obj_set_style_bg_color(bar, lv_color_hex(0x202020), LV_PART_MAIN);
+        lv_obj_add_style(bar, &style_bar_main_normal, LV_PART_MAIN);
         lv_obj_set_style_bg_opa(bar, 255, LV_PART_MAIN);
         lv_obj_set_style_radius(bar, 1, LV_PART_MAIN);
-        lv_obj_set_style_bg_color(bar, lv_color_hex(0x909090), LV_PART_INDICATOR);
+        lv_obj_add_style(bar, &style_bar_indicator_normal, LV_PART_INDICATOR);
         lv_obj_set_style_bg_opa(bar, 255, LV_PART_INDICATOR);
-        lv_obj_set_style_bg_grad_color(bar, lv_color_hex(0xf0f0f0), LV_PART_INDICATOR);
         lv_obj_set_style_bg_dither_mode(bar, LV_DITHER_ERR_DIFF, LV_PART_INDICATOR);
         lv_obj_set_style_bg_grad_dir(bar, LV_GRAD_DIR_HOR, LV_PART_INDICATOR);
         lv_obj_set_style_radius(bar, 1, LV_PART_INDICATOR);
@@ -171,7 +203,7 @@ int zmk_widget_battery_bar_init(struct zmk_widget_battery_bar *widget, lv_obj_t
 
         lv_obj_t *num = lv_label_create(info_container);
         lv_obj_set_style_text_font(num, &FoundryGridnikMedium_20, 0);
-        lv_obj_set_style_text_color(num, lv_color_white(), 0);
+        lv_obj_add_style(num, &style_num_normal, 0);
         lv_obj_set_style_opa(num, 255, 0);
         lv_obj_align(num, LV_ALIGN_CENTER, 0, 0);
         lv_label_set_text(num, "N/A");
@@ -190,13 +222,25 @@ int zmk_widget_battery_bar_init(struct zmk_widget_battery_bar *widget, lv_obj_t
         lv_obj_align(nc_num, LV_ALIGN_CENTER, 0, 0);
         lv_label_set_text(nc_num, LV_SYMBOL_CLOSE);
         lv_obj_set_style_opa(nc_num, 255, 0);
+
+        widget->peripherals[i] = (struct zmk_widget_battery_bar_peripheral){
+            .container = info_container,
+            .bar = bar,
+            .num = num,
+            .nc_bar = nc_bar,
+            .nc_num = nc_num,
+            .low = false,
+        };
+
+        LOG_DBG("Peripheral %d bar: %d B of objects, styles shared", i,
+                (int)(2 * sizeof(lv_obj_t) + sizeof(lv_bar_t) + 2 * sizeof(lv_label_t)));
     }
 
+    battery_bar_apply_order(widget);
     sys_slist_append(&widgets, &widget->node);
 
-    widget_battery_bar_battery_init();
-    widget_battery_bar_connection_init();
     initialized = true;
+    indicators_subscribe(&battery_bar_subscriber);
 
     return 0;
 }
@@ -2,11 +2,25 @@
 
 #include <lvgl.h>
 #include <zephyr/kernel.h>
+#include <zmk/ble.h>
+
+struct zmk_widget_battery_bar_peripheral {
+    lv_obj_t *container;
+    lv_obj_t *bar;
+    lv_obj_t *num;
+    lv_obj_t *nc_bar;
+    lv_obj_t *nc_num;
+    bool low;
+};
 
 struct zmk_widget_battery_bar {
     sys_snode_t node;
     lv_obj_t *obj;
+    struct zmk_widget_battery_bar_peripheral peripherals[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
 };
 
 int zmk_widget_battery_bar_init(struct zmk_widget_battery_bar *widget, lv_obj_t *parent);
-lv_obj_t *zmk_widget_battery_bar_obj(struct zmk_widget_battery_bar *widget);
\ No newline at end of file
+lv_obj_t *zmk_widget_battery_bar_obj(struct zmk_widget_battery_bar *widget);
+
+// Move every peripheral to its position from peripheral_order_position()
+void zmk_widget_battery_bar_order_changed(void);
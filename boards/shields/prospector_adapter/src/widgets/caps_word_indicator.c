@@ -1,10 +1,9 @@
 #include "caps_word_indicator.h"
 
 #include <zmk/display.h>
-#include <zmk/events/caps_word_state_changed.h>
-#include <zmk/event_manager.h>
 
 #include <fonts.h>
+#include <indicators.h>
 #include <sf_symbols.h>
 
 #include <zephyr/logging/log.h>
@@ -12,37 +11,28 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 static sys_slist_t widgets = SYS_SLIST_STATIC_INIT(&widgets);
 
-struct caps_word_indicator_state {
-    bool active;
-};
-
-static void caps_word_indicator_set_active(lv_obj_t *label, struct caps_word_indicator_state state) {
-    if (state.active) {
+static void caps_word_indicator_set_active(lv_obj_t *label, bool active) {
+    if (active) {
         lv_obj_set_style_text_color(label, lv_color_hex(0x00ffe5), LV_PART_MAIN);
     } else {
         lv_obj_set_style_text_color(label, lv_color_hex(0x202020), LV_PART_MAIN);
     }
 }
 
-static void caps_word_indicator_update_cb(struct caps_word_indicator_state state) {
+static void caps_word_indicator_update_cb(const struct indicator_state *state, uint32_t changed) {
+    bool active = state->flags & BIT(INDICATOR_CAPS_WORD);
+    LOG_INF("DISP | Caps Word State Changed: %d", active);
+
     struct zmk_widget_caps_word_indicator *widget;
     SYS_SLIST_FOR_EACH_CONTAINER(&widgets, widget, node) {
-        caps_word_indicator_set_active(widget->obj, state);
+        caps_word_indicator_set_active(widget->obj, active);
     }
 }
 
-static struct caps_word_indicator_state caps_word_indicator_get_state(const zmk_event_t *eh) {
-    const struct zmk_caps_word_state_changed *ev =
-        as_zmk_caps_word_state_changed(eh);
-    LOG_INF("DISP | Caps Word State Changed: %d", ev->active);
-    return (struct caps_word_indicator_state){
-        .active = ev->active,
-    };
-}
-
-ZMK_DISPLAY_WIDGET_LISTENER(widget_caps_word_indicator, struct caps_word_indicator_state,
-                            caps_word_indicator_update_cb, caps_word_indicator_get_state)
-ZMK_SUBSCRIPTION(widget_caps_word_indicator, zmk_caps_word_state_changed);
+static struct indicator_subscriber caps_word_indicator_subscriber = {
+    .mask = BIT(INDICATOR_CAPS_WORD),
+    .cb = caps_word_indicator_update_cb,
+};
 
 int zmk_widget_caps_word_indicator_init(struct zmk_widget_caps_word_indicator *widget,
                                         lv_obj_t *parent) {
@@ -57,7 +47,7 @@ int zmk_widget_caps_word_indicator_init(struct zmk_widget_caps_word_indicator *w
 
     sys_slist_append(&widgets, &widget->node);
 
-    widget_caps_word_indicator_init();
+    indicators_subscribe(&caps_word_indicator_subscriber);
     return 0;
 }
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zmk/display.h>
+#include <zmk/event_manager.h>
+
+#include <zephyr/logging/log.h>
+
+// Counters for a coalesced widget listener: events merged into the pending
+// state versus renders actually applied on the display work queue
+struct zmk_widget_coalesce_stats {
+    atomic_t received;
+    atomic_t applied;
+};
+
+// Drop-in replacement for ZMK_DISPLAY_WIDGET_LISTENER that merges every event
+// into a pending state with merge(state_type *pending, state_type update) and
+// renders it at most once per LVGL refresh period. The pending state is reset
+// to zero after each render, so merge must treat a zeroed state as "nothing
+// changed yet".
+#define ZMK_DISPLAY_COALESCED_WIDGET_LISTENER(listener, state_type, merge, cb, state_func)         \
+    K_MUTEX_DEFINE(listener##_mutex);                                                              \
+    static state_type __##listener##_pending;                                                      \
+    static struct zmk_widget_coalesce_stats listener##_stats;                                      \
+    static void listener##_work_cb(struct k_work *work) {                                          \
+        k_mutex_lock(&listener##_mutex, K_FOREVER);                                                \
+        state_type state = __##listener##_pending;                                                 \
+        __##listener##_pending = (state_type){0};                                                  \
+        k_mutex_unlock(&listener##_mutex);                                                         \
+        atomic_inc(&listener##_stats.applied);                                                     \
+        LOG_DBG(#listener ": %d events, %d updates applied",                                       \
+                (int)atomic_get(&listener##_stats.received),                                       \
+                (int)atomic_get(&listener##_stats.applied));                                       \
+        cb(state);                                                                                 \
+    }                                                                                              \
+    K_WORK_DELAYABLE_DEFINE(listener##_work, listener##_work_cb);                                  \
+    static void listener##_refresh() {                                                             \
+        k_mutex_lock(&listener##_mutex, K_FOREVER);                                                \
+        merge(&__##listener##_pending, state_func(NULL));                                          \
+        k_mutex_unlock(&listener##_mutex);                                                         \
+        listener##_work_cb(NULL);                                                                  \
+    }                                                                                              \
+    static int listener##_cb(const zmk_event_t *eh) {                                              \
+        if (zmk_display_is_initialized()) {                                                        \
+            k_mutex_lock(&listener##_mutex, K_FOREVER);                                            \
+            merge(&__##listener##_pending, state_func(eh));                                        \
+            k_mutex_unlock(&listener##_mutex);                                                     \
+            atomic_inc(&listener##_stats.received);                                                \
+            k_work_schedule_for_queue(zmk_display_work_q(), &listener##_work,                      \
+                                      K_MSEC(CONFIG_LV_DISP_DEF_REFR_PERIOD));                     \
+        }                                                                                          \
+        return ZMK_EV_EVENT_BUBBLE;                                                                \
+    }                                                                                              \
+    ZMK_LISTENER(listener, listener##_cb);                                                         \
+    static int listener##_init() {                                                                 \
+        listener##_refresh();                                                                      \
+        return 0;                                                                                  \
+    }
@@ -0,0 +1,63 @@
+#include "latency_stats.h"
+
+#include <stdio.h>
+
+#include <zmk/ble.h>
+
+#include <prospector/keystroke_latency.h>
+
+#include <fonts.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define LATENCY_STATS_REFRESH_MS 1000
+
+// One "p50/p95" line per peripheral, relabeled only when new presses arrived
+static void latency_stats_refresh(lv_timer_t *timer) {
+    struct zmk_widget_latency_stats *widget = timer->user_data;
+    char text[ZMK_SPLIT_BLE_PERIPHERAL_COUNT * 16];
+    uint32_t total = 0;
+    int len = 0;
+
+    for (uint8_t slot = 0; slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; slot++) {
+        struct prospector_latency_histogram hist;
+
+        prospector_latency_get(slot, &hist);
+        total += hist.count;
+
+        if (hist.count == 0) {
+            len += snprintf(text + len, sizeof(text) - len, "%s-/-", slot ? "\n" : "");
+        } else {
+            len += snprintf(text + len, sizeof(text) - len, "%s%d/%d", slot ? "\n" : "",
+                            prospector_latency_percentile(&hist, 50),
+                            prospector_latency_percentile(&hist, 95));
+        }
+        len = MIN(len, (int)sizeof(text) - 1);
+    }
+
+    if (total == widget->shown) {
+        return;
+    }
+
+    widget->shown = total;
+    lv_label_set_text(widget->obj, text);
+}
+
+int zmk_widget_latency_stats_init(struct zmk_widget_latency_stats *widget, lv_obj_t *parent) {
+    widget->obj = lv_label_create(parent);
+    widget->shown = UINT32_MAX;
+
+    lv_obj_set_style_text_color(widget->obj, lv_color_hex(0x606060), LV_PART_MAIN);
+    lv_obj_set_style_text_font(widget->obj, &FoundryGridnikMedium_20, LV_PART_MAIN);
+    lv_obj_set_style_text_align(widget->obj, LV_TEXT_ALIGN_RIGHT, LV_PART_MAIN);
+
+    widget->timer = lv_timer_create(latency_stats_refresh, LATENCY_STATS_REFRESH_MS, widget);
+    latency_stats_refresh(widget->timer);
+
+    return 0;
+}
+
+lv_obj_t *zmk_widget_latency_stats_obj(struct zmk_widget_latency_stats *widget) {
+    return widget->obj;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <lvgl.h>
+#include <zephyr/kernel.h>
+
+struct zmk_widget_latency_stats {
+    lv_obj_t *obj;
+    lv_timer_t *timer;
+    uint32_t shown;
+};
+
+int zmk_widget_latency_stats_init(struct zmk_widget_latency_stats *widget, lv_obj_t *parent);
+lv_obj_t *zmk_widget_latency_stats_obj(struct zmk_widget_latency_stats *widget);
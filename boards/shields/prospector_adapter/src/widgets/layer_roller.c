@@ -1,32 +1,147 @@
 #include "layer_roller.h"
 
-#include <ctype.h>
+#include <string.h>
+
 #include <zmk/display.h>
 #include <zmk/events/layer_state_changed.h>
 #include <zmk/event_manager.h>
 #include <zmk/keymap.h>
 
 #include <fonts.h>
+#include <prospector_layer_names.h>
+
+#include "coalesce.h"
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
-static char layer_names_buffer[256] = {0}; // Buffer for concatenated layer names
+// Layer names, generated from the keymap at build time
+static const char *const layer_names[] = {PROSPECTOR_LAYER_NAMES};
+
+BUILD_ASSERT(PROSPECTOR_LAYER_NAMES_COUNT == ZMK_KEYMAP_LAYERS_LEN,
+             "Generated layer names are out of sync with the keymap");
 
 static sys_slist_t widgets = SYS_SLIST_STATIC_INIT(&widgets);
 
 struct layer_roller_state {
+    bool changed;
     uint8_t index;
 };
 
-static void layer_roller_set_sel(lv_obj_t *roller, struct layer_roller_state state) {
-    lv_roller_set_selected(roller, state.index, LV_ANIM_ON);
+static lv_style_t style_selected;
+
+static const char *layer_roller_name(int index) {
+    return layer_names[(index + ZMK_KEYMAP_LAYERS_LEN) % ZMK_KEYMAP_LAYERS_LEN];
+}
+
+// Same pitch as the lv_roller this replaces: a line of text plus the line
+// space, which the mask below also leaves clear around the selection
+static lv_coord_t layer_roller_row_height(struct zmk_widget_layer_roller *widget) {
+    return lv_font_get_line_height(&FRAC_Thin_48) +
+           lv_obj_get_style_text_line_space(widget->obj, LV_PART_MAIN);
+}
+
+// Rows 0-2 sit above, on and below the selection, the spare row is parked
+// two rows away on the side the roller is scrolling from
+static void layer_roller_layout(struct zmk_widget_layer_roller *widget) {
+    lv_coord_t row_h = layer_roller_row_height(widget);
+
+    for (int i = 0; i < LAYER_ROLLER_ROW_SPARE; i++) {
+        lv_obj_align(widget->rows[i], LV_ALIGN_CENTER, 0, (i - 1) * row_h - widget->scroll);
+    }
+    lv_obj_align(widget->rows[LAYER_ROLLER_ROW_SPARE], LV_ALIGN_CENTER, 0,
+                 (widget->direction < 0 ? -2 : 2) * row_h - widget->scroll);
+}
+
+static void layer_roller_relabel(struct zmk_widget_layer_roller *widget) {
+    lv_label_set_text_static(widget->rows[0], layer_roller_name(widget->selected - 1));
+    lv_label_set_text_static(widget->rows[1], layer_roller_name(widget->selected));
+    lv_label_set_text_static(widget->rows[2], layer_roller_name(widget->selected + 1));
+    lv_label_set_text_static(widget->rows[LAYER_ROLLER_ROW_SPARE], "");
+}
+
+static void layer_roller_finish(struct zmk_widget_layer_roller *widget) {
+    lv_obj_t *rows[LAYER_ROLLER_ROW_COUNT];
+    memcpy(rows, widget->rows, sizeof(rows));
+
+    // Recycle the row that scrolled out as the new spare
+    for (int i = 0; i < LAYER_ROLLER_ROW_COUNT; i++) {
+        widget->rows[i] = rows[(i + LAYER_ROLLER_ROW_COUNT + widget->direction) %
+                               LAYER_ROLLER_ROW_COUNT];
+    }
+
+    widget->direction = 0;
+    widget->scroll = 0;
+    layer_roller_relabel(widget);
+    layer_roller_layout(widget);
+}
+
+static void layer_roller_anim_cb(void *var, int32_t value) {
+    struct zmk_widget_layer_roller *widget = var;
+    widget->scroll = value;
+    layer_roller_layout(widget);
+}
+
+static void layer_roller_anim_ready_cb(lv_anim_t *a) { layer_roller_finish(a->var); }
+
+static void layer_roller_set_sel(struct zmk_widget_layer_roller *widget,
+                                 struct layer_roller_state state) {
+    if (state.index >= ZMK_KEYMAP_LAYERS_LEN) {
+        return;
+    }
+
+    if (widget->direction != 0) {
+        lv_anim_del(widget, layer_roller_anim_cb);
+        layer_roller_finish(widget);
+    }
+
+    if (state.index == widget->selected) {
+        return;
+    }
+
+    // Scroll one row along the shortest way around, jumps just relabel the
+    // incoming rows
+    int distance = (state.index - widget->selected + ZMK_KEYMAP_LAYERS_LEN) % ZMK_KEYMAP_LAYERS_LEN;
+    lv_obj_t *incoming;
+
+    if (distance <= ZMK_KEYMAP_LAYERS_LEN / 2) {
+        widget->direction = 1;
+        incoming = widget->rows[2];
+        lv_label_set_text_static(incoming, layer_roller_name(state.index));
+        lv_label_set_text_static(widget->rows[LAYER_ROLLER_ROW_SPARE],
+                                 layer_roller_name(state.index + 1));
+    } else {
+        widget->direction = -1;
+        incoming = widget->rows[0];
+        lv_label_set_text_static(incoming, layer_roller_name(state.index));
+        lv_label_set_text_static(widget->rows[LAYER_ROLLER_ROW_SPARE],
+                                 layer_roller_name(state.index - 1));
+    }
+
+    lv_obj_remove_style(widget->rows[1], &style_selected, 0);
+    lv_obj_add_style(incoming, &style_selected, 0);
+    widget->selected = state.index;
+    layer_roller_layout(widget);
+
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, widget);
+    lv_anim_set_exec_cb(&a, layer_roller_anim_cb);
+    lv_anim_set_ready_cb(&a, layer_roller_anim_ready_cb);
+    lv_anim_set_values(&a, 0, widget->direction * layer_roller_row_height(widget));
+    lv_anim_set_time(&a, lv_obj_get_style_anim_time(widget->obj, LV_PART_MAIN));
+    lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
+    lv_anim_start(&a);
 }
 
 static void layer_roller_update_cb(struct layer_roller_state state) {
+    if (!state.changed) {
+        return;
+    }
+
     struct zmk_widget_layer_roller *widget;
     SYS_SLIST_FOR_EACH_CONTAINER(&widgets, widget, node) {
-        layer_roller_set_sel(widget->obj, state);
+        layer_roller_set_sel(widget, state);
     }
 }
 
@@ -34,12 +149,21 @@ static struct layer_roller_state layer_roller_get_state(const zmk_event_t *eh) {
     uint8_t index = zmk_keymap_highest_layer_active();
     LOG_INF("Roller set to: %d", index);
     return (struct layer_roller_state){
+        .changed = true,
         .index = index,
     };
 }
 
-ZMK_DISPLAY_WIDGET_LISTENER(widget_layer_roller, struct layer_roller_state, layer_roller_update_cb,
-                            layer_roller_get_state)
+static void layer_roller_merge_state(struct layer_roller_state *pending,
+                                     struct layer_roller_state update) {
+    if (update.changed) {
+        *pending = update;
+    }
+}
+
+ZMK_DISPLAY_COALESCED_WIDGET_LISTENER(widget_layer_roller, struct layer_roller_state,
+                                      layer_roller_merge_state, layer_roller_update_cb,
+                                      layer_roller_get_state)
 ZMK_SUBSCRIPTION(widget_layer_roller, zmk_layer_state_changed);
 
 static void mask_event_cb(lv_event_t * e)
@@ -94,42 +218,8 @@ static void mask_event_cb(lv_event_t * e)
 }
 
 int zmk_widget_layer_roller_init(struct zmk_widget_layer_roller *widget, lv_obj_t *parent) {
-    widget->obj = lv_roller_create(parent);
-
-    layer_names_buffer[0] = '\0';
-    char *ptr = layer_names_buffer;
-
-    for (int i = 0; i < ZMK_KEYMAP_LAYERS_LEN; i++) {
-        const char *layer_name = zmk_keymap_layer_name(zmk_keymap_layer_index_to_id(i));
-        if (layer_name) {
-            if (i > 0) {
-                strcat(ptr, "\n");
-                ptr += strlen(ptr);
-            }
-
-            if (layer_name && *layer_name) {
-#if IS_ENABLED(CONFIG_LAYER_ROLLER_ALL_CAPS)
-                while (*layer_name) {
-                    *ptr = toupper((unsigned char)*layer_name);
-                    ptr++;
-                    layer_name++;
-                }
-                *ptr = '\0';
-#else
-                strcat(ptr, layer_name);
-                ptr += strlen(layer_name);
-#endif
-            } else {
-                // Just use the number for unnamed layers
-                char index_str[12];
-                snprintf(index_str, sizeof(index_str), "%d", i);
-                strcat(ptr, index_str);
-                ptr += strlen(index_str);
-            }
-        }
-    }
-
-    lv_roller_set_options(widget->obj, layer_names_buffer, LV_ROLLER_MODE_INFINITE);
+    widget->obj = lv_obj_create(parent);
+    lv_obj_clear_flag(widget->obj, LV_OBJ_FLAG_SCROLLABLE);
 
     static lv_style_t style;
     lv_style_init(&style);
@@ -141,14 +231,29 @@ int zmk_widget_layer_roller_init(struct zmk_widget_layer_roller *widget, lv_obj_
     // lv_obj_add_style(lv_scr_act(), &style, 0);
 
     lv_obj_add_style(widget->obj, &style, 0);
-    lv_obj_set_style_bg_opa(widget->obj, LV_OPA_TRANSP, LV_PART_SELECTED);
-    lv_obj_set_style_text_font(widget->obj, &FRAC_Regular_48, LV_PART_SELECTED);
-    lv_obj_set_style_text_color(widget->obj, lv_color_hex(0xffffff), LV_PART_SELECTED);
-    // lv_obj_set_style_text_line_space(widget->obj, 20, LV_PART_SELECTED);
-    // lv_obj_set_style_text_line_space(widget->obj, 20, LV_PART_MAIN);
     lv_obj_set_style_text_font(widget->obj, &FRAC_Thin_48, LV_PART_MAIN);
     lv_obj_set_style_text_color(widget->obj, lv_color_hex(0x909090), LV_PART_MAIN);
-    // lv_obj_set_style_text_align(widget->obj, LV_TEXT_ALIGN_CENTER, 0);
+    // The default theme gave the roller centered text and its large line space
+    lv_obj_set_style_text_align(widget->obj, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(widget->obj, lv_disp_dpx(lv_obj_get_disp(widget->obj), 20),
+                                     LV_PART_MAIN);
+
+    lv_style_init(&style_selected);
+    lv_style_set_text_font(&style_selected, &FRAC_Regular_48);
+    lv_style_set_text_color(&style_selected, lv_color_hex(0xffffff));
+
+    // Only the visible neighbourhood of the selection is backed by labels,
+    // they get recycled as the roller scrolls
+    for (int i = 0; i < LAYER_ROLLER_ROW_COUNT; i++) {
+        widget->rows[i] = lv_label_create(widget->obj);
+    }
+    lv_obj_add_style(widget->rows[1], &style_selected, 0);
+
+    widget->selected = 0;
+    widget->direction = 0;
+    widget->scroll = 0;
+    layer_roller_relabel(widget);
+    layer_roller_layout(widget);
 
     lv_obj_add_event_cb(widget->obj, mask_event_cb, LV_EVENT_ALL, NULL);
 
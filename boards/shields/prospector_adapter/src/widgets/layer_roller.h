@@ -3,9 +3,16 @@
 #include <lvgl.h>
 #include <zephyr/kernel.h>
 
+#define LAYER_ROLLER_ROW_COUNT 4
+#define LAYER_ROLLER_ROW_SPARE 3
+
 struct zmk_widget_layer_roller {
     sys_snode_t node;
     lv_obj_t *obj;
+    lv_obj_t *rows[LAYER_ROLLER_ROW_COUNT];
+    uint8_t selected;
+    int8_t direction;
+    lv_coord_t scroll;
 };
 
 int zmk_widget_layer_roller_init(struct zmk_widget_layer_roller *widget, lv_obj_t *parent);
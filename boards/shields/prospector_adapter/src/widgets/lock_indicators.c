@@ -0,0 +1,80 @@
+#include "lock_indicators.h"
+
+#include <zmk/display.h>
+
+#include <fonts.h>
+#include <indicators.h>
+#include <sf_symbols.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+static sys_slist_t widgets = SYS_SLIST_STATIC_INIT(&widgets);
+
+// Every glyph is drawn once with its final text and never relabeled, a lock
+// change only swaps its opacity so LVGL redraws just the glyph's own area
+#define LOCK_OPA_ON LV_OPA_COVER
+#define LOCK_OPA_OFF LV_OPA_20
+
+static const uint8_t lock_bits[ZMK_WIDGET_LOCK_COUNT] = {
+    [ZMK_WIDGET_LOCK_CAPS] = INDICATOR_CAPS_LOCK,
+    [ZMK_WIDGET_LOCK_NUM] = INDICATOR_NUM_LOCK,
+    [ZMK_WIDGET_LOCK_SCROLL] = INDICATOR_SCROLL_LOCK,
+};
+
+static void lock_indicators_update_cb(const struct indicator_state *state, uint32_t changed) {
+    struct zmk_widget_lock_indicators *widget;
+    SYS_SLIST_FOR_EACH_CONTAINER(&widgets, widget, node) {
+        for (int i = 0; i < ZMK_WIDGET_LOCK_COUNT; i++) {
+            if (!(changed & BIT(lock_bits[i]))) {
+                continue;
+            }
+
+            lv_obj_t *glyph = widget->glyphs[i];
+            bool on = state->flags & BIT(lock_bits[i]);
+            lv_obj_set_style_opa(glyph, on ? LOCK_OPA_ON : LOCK_OPA_OFF, LV_PART_MAIN);
+        }
+    }
+}
+
+static struct indicator_subscriber lock_indicators_subscriber = {
+    .mask = BIT(INDICATOR_CAPS_LOCK) | BIT(INDICATOR_NUM_LOCK) | BIT(INDICATOR_SCROLL_LOCK),
+    .cb = lock_indicators_update_cb,
+};
+
+static lv_obj_t *lock_indicators_glyph_create(lv_obj_t *parent, const char *text,
+                                              const lv_font_t *font) {
+    lv_obj_t *glyph = lv_label_create(parent);
+    lv_label_set_text_static(glyph, text);
+    lv_obj_set_style_text_font(glyph, font, LV_PART_MAIN);
+    lv_obj_set_style_text_color(glyph, lv_color_hex(0xffffff), LV_PART_MAIN);
+    lv_obj_set_style_opa(glyph, LOCK_OPA_OFF, LV_PART_MAIN);
+    return glyph;
+}
+
+int zmk_widget_lock_indicators_init(struct zmk_widget_lock_indicators *widget, lv_obj_t *parent) {
+    widget->obj = lv_obj_create(parent);
+    lv_obj_set_size(widget->obj, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(widget->obj, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_flex_align(widget->obj, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER,
+                          LV_FLEX_ALIGN_CENTER);
+    lv_obj_set_style_pad_row(widget->obj, 2, LV_PART_MAIN);
+
+    // Only the caps lock symbol exists in the SF font, the others are spelled
+    // out in the battery bar's font
+    widget->glyphs[ZMK_WIDGET_LOCK_CAPS] = lock_indicators_glyph_create(
+        widget->obj, SF_SYMBOL_CAPS_LOCK, &SF_Compact_Text_Bold_32);
+    widget->glyphs[ZMK_WIDGET_LOCK_NUM] =
+        lock_indicators_glyph_create(widget->obj, "NUM", &FoundryGridnikMedium_20);
+    widget->glyphs[ZMK_WIDGET_LOCK_SCROLL] =
+        lock_indicators_glyph_create(widget->obj, "SCR", &FoundryGridnikMedium_20);
+
+    sys_slist_append(&widgets, &widget->node);
+
+    indicators_subscribe(&lock_indicators_subscriber);
+    return 0;
+}
+
+lv_obj_t *zmk_widget_lock_indicators_obj(struct zmk_widget_lock_indicators *widget) {
+    return widget->obj;
+}
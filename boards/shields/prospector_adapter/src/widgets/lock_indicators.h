@@ -0,0 +1,20 @@
+#pragma once
+
+#include <lvgl.h>
+#include <zephyr/kernel.h>
+
+enum zmk_widget_lock {
+    ZMK_WIDGET_LOCK_CAPS,
+    ZMK_WIDGET_LOCK_NUM,
+    ZMK_WIDGET_LOCK_SCROLL,
+    ZMK_WIDGET_LOCK_COUNT,
+};
+
+struct zmk_widget_lock_indicators {
+    sys_snode_t node;
+    lv_obj_t *obj;
+    lv_obj_t *glyphs[ZMK_WIDGET_LOCK_COUNT];
+};
+
+int zmk_widget_lock_indicators_init(struct zmk_widget_lock_indicators *widget, lv_obj_t *parent);
+lv_obj_t *zmk_widget_lock_indicators_obj(struct zmk_widget_lock_indicators *widget);
@@ -0,0 +1,15 @@
+#pragma once
+
+#define DISP_BRT_INC_CMD 0
+#define DISP_BRT_DEC_CMD 1
+#define DISP_BRT_SET_CMD 2
+#define DISP_BRT_AUTO_CMD 3
+
+/* INC and DEC step by CONFIG_PROSPECTOR_BRIGHTNESS_STEP, SET takes a fixed
+ * level (1-100) and AUTO an offset added to the ambient light curve, e.g.
+ * &disp_brt DISP_BRT_SET 60 or &disp_brt DISP_BRT_AUTO 0 */
+
+#define DISP_BRT_INC DISP_BRT_INC_CMD 0
+#define DISP_BRT_DEC DISP_BRT_DEC_CMD 0
+#define DISP_BRT_SET DISP_BRT_SET_CMD
+#define DISP_BRT_AUTO DISP_BRT_AUTO_CMD
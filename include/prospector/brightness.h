@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Use a fixed display brightness (1-100) instead of following ambient light
+int prospector_brightness_set(uint8_t level);
+
+// Follow ambient light again, shifted by offset percentage points
+int prospector_brightness_set_auto(int8_t offset);
+
+// Step the fixed brightness, or the auto offset when following ambient light
+int prospector_brightness_adjust(int8_t delta);
+
+bool prospector_brightness_is_auto(void);
+uint8_t prospector_brightness_get_level(void);
+int8_t prospector_brightness_get_offset(void);
+
+// Cap the applied brightness without changing the setting, 0 turns the
+// backlight off and 100 lifts the cap
+void prospector_brightness_set_limit(uint8_t limit);
+
+// Stop and restart ambient light sensing while the display is off
+void prospector_brightness_suspend(void);
+void prospector_brightness_resume(void);
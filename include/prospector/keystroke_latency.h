@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+// Bucket 0 holds latencies under 1 ms, bucket n those from 2^(n-1) up to
+// 2^n ms, and the last bucket everything longer
+#define PROSPECTOR_LATENCY_BUCKETS 12
+
+struct prospector_latency_histogram {
+    uint32_t buckets[PROSPECTOR_LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_ms;
+};
+
+// Copy the histogram of key presses received from the split peripheral in slot
+int prospector_latency_get(uint8_t slot, struct prospector_latency_histogram *out);
+
+void prospector_latency_reset(void);
+
+// Upper bound in ms of the bucket holding the given percentile, -1 if empty
+int prospector_latency_percentile(const struct prospector_latency_histogram *hist,
+                                  uint8_t percent);
@@ -6,6 +6,16 @@
 struct zmk_split_central_status_changed {
     uint8_t slot;
     bool connected;
+    // HCI reason of the disconnect, 0 when connected
+    uint8_t reason;
+    // Hash of the peer's identity address, the same for every connection of
+    // a bonded peripheral and never 0
+    uint32_t addr_hash;
+    // Negotiated parameters in controller units (1.25 ms, events, 10 ms), 0
+    // when disconnected
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t timeout;
 };
 
-ZMK_EVENT_DECLARE(zmk_split_central_status_changed);
\ No newline at end of file
+ZMK_EVENT_DECLARE(zmk_split_central_status_changed);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zmk/event_manager.h>
+
+#define ZMK_SPLIT_PERIPHERAL_RSSI_UNKNOWN INT8_MIN
+
+// Link state of one split peripheral, in the units the controller reports
+struct zmk_split_peripheral_link {
+    uint16_t interval; // 1.25 ms units
+    uint16_t latency;  // connection events the peripheral may skip
+    uint16_t timeout;  // 10 ms units
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    int8_t rssi; // dBm, ZMK_SPLIT_PERIPHERAL_RSSI_UNKNOWN until sampled
+    uint8_t disconnect_reason; // HCI reason of the last disconnect, 0 if none
+    bool connected;
+};
+
+struct zmk_split_peripheral_link_changed {
+    uint8_t slot;
+    struct zmk_split_peripheral_link link;
+};
+
+ZMK_EVENT_DECLARE(zmk_split_peripheral_link_changed);
@@ -7,6 +7,7 @@
 #define DT_DRV_COMPAT zmk_behavior_caps_word
 
 #include <zephyr/device.h>
+#include <zephyr/sys/atomic.h>
 #include <drivers/behavior.h>
 #include <zephyr/logging/log.h>
 #include <zmk/behavior.h>
@@ -31,30 +32,53 @@ struct caps_word_continue_item {
     uint8_t implicit_modifiers;
 };
 
+// Keyboard page usage ids fit in 8 words of 32 bits
+#define CAPS_WORD_KEY_WORDS 8
+
 struct behavior_caps_word_config {
     zmk_mod_flags_t mods;
     uint8_t index;
+    // Keyboard page usages in the continue-list without implicit modifiers,
+    // which continue caps word whatever modifiers are held
+    uint32_t key_continue[CAPS_WORD_KEY_WORDS];
+    // Keyboard page usages listed with implicit modifiers, which still need
+    // the modifier check against continuations[]
+    uint32_t key_conditional[CAPS_WORD_KEY_WORDS];
     uint8_t continuations_count;
     struct caps_word_continue_item continuations[];
 };
 
-struct behavior_caps_word_data {
-    bool active;
-};
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) <= ATOMIC_BITS,
+             "Too many caps word instances for the active mask");
+
+// One bit per instance index, so the keycode listener can tell with a single
+// load that caps word is off
+static atomic_t active_instances;
+
+static bool caps_word_is_active(const struct device *dev) {
+    const struct behavior_caps_word_config *config = dev->config;
+    return atomic_test_bit(&active_instances, config->index);
+}
 
+// The state event has no instance, so it reports whether any caps word is on
+// and is only raised when that changes
 static void activate_caps_word(const struct device *dev) {
-    struct behavior_caps_word_data *data = dev->data;
+    const struct behavior_caps_word_config *config = dev->config;
 
-    data->active = true;
+    if (atomic_or(&active_instances, BIT(config->index)) != 0) {
+        return;
+    }
 
     raise_zmk_caps_word_state_changed(
         (struct zmk_caps_word_state_changed){.active = true});
 }
 
 static void deactivate_caps_word(const struct device *dev) {
-    struct behavior_caps_word_data *data = dev->data;
+    const struct behavior_caps_word_config *config = dev->config;
 
-    data->active = false;
+    if (atomic_and(&active_instances, ~BIT(config->index)) != BIT(config->index)) {
+        return;
+    }
 
     raise_zmk_caps_word_state_changed(
         (struct zmk_caps_word_state_changed){.active = false});
@@ -63,9 +87,8 @@ static void deactivate_caps_word(const struct device *dev) {
 static int on_caps_word_binding_pressed(struct zmk_behavior_binding *binding,
                                         struct zmk_behavior_binding_event event) {
     const struct device *dev = zmk_behavior_get_binding(binding->behavior_dev);
-    struct behavior_caps_word_data *data = dev->data;
 
-    if (data->active) {
+    if (caps_word_is_active(dev)) {
         deactivate_caps_word(dev);
     } else {
         activate_caps_word(dev);
@@ -94,18 +117,33 @@ ZMK_SUBSCRIPTION(behavior_caps_word, zmk_keycode_state_changed);
 
 static const struct device *devs[DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT)];
 
+static bool caps_word_key_bit(const uint32_t *words, uint32_t usage_id) {
+    return words[usage_id >> 5] & BIT(usage_id & 0x1F);
+}
+
 static bool caps_word_is_caps_includelist(const struct behavior_caps_word_config *config,
-                                          uint16_t usage_page, uint8_t usage_id,
+                                          uint16_t usage_page, uint32_t usage_id,
                                           uint8_t implicit_modifiers) {
+    if (usage_page == HID_USAGE_KEY && usage_id < CAPS_WORD_KEY_WORDS * 32) {
+        if (caps_word_key_bit(config->key_continue, usage_id)) {
+            LOG_DBG("Continuing capsword, found included usage: 0x%02X - 0x%02X", usage_page,
+                    usage_id);
+            return true;
+        }
+
+        if (!caps_word_key_bit(config->key_conditional, usage_id)) {
+            return false;
+        }
+    }
+
+    // Only usages with modifier requirements or from other pages get here
+    uint8_t mods = implicit_modifiers | zmk_hid_get_explicit_mods();
+
     for (int i = 0; i < config->continuations_count; i++) {
         const struct caps_word_continue_item *continuation = &config->continuations[i];
-        LOG_DBG("Comparing with 0x%02X - 0x%02X (with implicit mods: 0x%02X)", continuation->page,
-                continuation->id, continuation->implicit_modifiers);
 
         if (continuation->page == usage_page && continuation->id == usage_id &&
-            (continuation->implicit_modifiers &
-             (implicit_modifiers | zmk_hid_get_explicit_mods())) ==
-                continuation->implicit_modifiers) {
+            (continuation->implicit_modifiers & mods) == continuation->implicit_modifiers) {
             LOG_DBG("Continuing capsword, found included usage: 0x%02X - 0x%02X", usage_page,
                     usage_id);
             return true;
@@ -135,22 +173,25 @@ static void caps_word_enhance_usage(const struct behavior_caps_word_config *conf
 }
 
 static int caps_word_keycode_state_changed_listener(const zmk_event_t *eh) {
+    atomic_val_t active = atomic_get(&active_instances);
+    if (active == 0) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
     struct zmk_keycode_state_changed *ev = as_zmk_keycode_state_changed(eh);
     if (ev == NULL || !ev->state) {
         return ZMK_EV_EVENT_BUBBLE;
     }
 
-    for (int i = 0; i < DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT); i++) {
+    while (active) {
+        int i = __builtin_ctz(active);
+        active &= active - 1;
+
         const struct device *dev = devs[i];
         if (dev == NULL) {
             continue;
         }
 
-        struct behavior_caps_word_data *data = dev->data;
-        if (!data->active) {
-            continue;
-        }
-
         const struct behavior_caps_word_config *config = dev->config;
 
         caps_word_enhance_usage(config, ev);
@@ -180,15 +221,37 @@ static int behavior_caps_word_init(const struct device *dev) {
 
 #define BREAK_ITEM(i, n) PARSE_BREAK(DT_INST_PROP_BY_IDX(n, continue_list, i))
 
+// Bit for a keyboard page usage in word w of the continue bitmaps, or 0 when
+// the usage is elsewhere or has the wrong kind of modifier requirement
+#define KEY_BIT(usage, w, conditional)                                                             \
+    ((ZMK_HID_USAGE_PAGE(usage) == HID_USAGE_KEY && (SELECT_MODS(usage) != 0) == (conditional) && \
+      (ZMK_HID_USAGE_ID(usage) >> 5) == (w))                                                       \
+         ? BIT(ZMK_HID_USAGE_ID(usage) & 0x1F)                                                     \
+         : 0)
+
+#define KEY_BIT_ITEM(i, n, w, conditional)                                                         \
+    | KEY_BIT(DT_INST_PROP_BY_IDX(n, continue_list, i), w, conditional)
+
+#define KEY_WORD(n, w, conditional)                                                                \
+    (0 LISTIFY(DT_INST_PROP_LEN(n, continue_list), KEY_BIT_ITEM, (), n, w, conditional))
+
+#define KEY_WORDS(n, conditional)                                                                  \
+    {                                                                                              \
+        KEY_WORD(n, 0, conditional), KEY_WORD(n, 1, conditional), KEY_WORD(n, 2, conditional),     \
+            KEY_WORD(n, 3, conditional), KEY_WORD(n, 4, conditional),                              \
+            KEY_WORD(n, 5, conditional), KEY_WORD(n, 6, conditional), KEY_WORD(n, 7, conditional), \
+    }
+
 #define KP_INST(n)                                                                                 \
-    static struct behavior_caps_word_data behavior_caps_word_data_##n = {.active = false};         \
     static struct behavior_caps_word_config behavior_caps_word_config_##n = {                      \
         .index = n,                                                                                \
         .mods = DT_INST_PROP_OR(n, mods, MOD_LSFT),                                                \
+        .key_continue = KEY_WORDS(n, 0),                                                           \
+        .key_conditional = KEY_WORDS(n, 1),                                                        \
         .continuations = {LISTIFY(DT_INST_PROP_LEN(n, continue_list), BREAK_ITEM, (, ), n)},       \
         .continuations_count = DT_INST_PROP_LEN(n, continue_list),                                 \
     };                                                                                             \
-    BEHAVIOR_DT_INST_DEFINE(n, behavior_caps_word_init, NULL, &behavior_caps_word_data_##n,        \
+    BEHAVIOR_DT_INST_DEFINE(n, behavior_caps_word_init, NULL, NULL,                                \
                             &behavior_caps_word_config_##n, POST_KERNEL,                           \
                             CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &behavior_caps_word_driver_api);
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_behavior_display_brightness
+
+#include <zephyr/device.h>
+#include <drivers/behavior.h>
+#include <zephyr/logging/log.h>
+#include <zmk/behavior.h>
+
+#include <dt-bindings/zmk/display_brightness.h>
+#include <prospector/brightness.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
+
+// Levels and offsets in percent, as documented in display_brightness.h
+#define DISP_BRT_LEVEL_MIN 1
+#define DISP_BRT_LEVEL_MAX 100
+
+static int on_display_brightness_binding_pressed(struct zmk_behavior_binding *binding,
+                                                 struct zmk_behavior_binding_event event) {
+    // Negative AUTO offsets arrive as two's complement devicetree cells
+    int32_t value = (int32_t)binding->param2;
+    int err;
+
+    switch (binding->param1) {
+    case DISP_BRT_INC_CMD:
+        err = prospector_brightness_adjust(CONFIG_PROSPECTOR_BRIGHTNESS_STEP);
+        break;
+    case DISP_BRT_DEC_CMD:
+        err = prospector_brightness_adjust(-CONFIG_PROSPECTOR_BRIGHTNESS_STEP);
+        break;
+    case DISP_BRT_SET_CMD:
+        if (value < DISP_BRT_LEVEL_MIN || value > DISP_BRT_LEVEL_MAX) {
+            LOG_ERR("Display brightness %d out of range %d-%d", value, DISP_BRT_LEVEL_MIN,
+                    DISP_BRT_LEVEL_MAX);
+            return ZMK_BEHAVIOR_OPAQUE;
+        }
+        err = prospector_brightness_set((uint8_t)value);
+        break;
+    case DISP_BRT_AUTO_CMD:
+        if (value < -DISP_BRT_LEVEL_MAX || value > DISP_BRT_LEVEL_MAX) {
+            LOG_ERR("Display brightness offset %d out of range %d-%d", value,
+                    -DISP_BRT_LEVEL_MAX, DISP_BRT_LEVEL_MAX);
+            return ZMK_BEHAVIOR_OPAQUE;
+        }
+        err = prospector_brightness_set_auto((int8_t)value);
+        break;
+    default:
+        LOG_ERR("Unknown display brightness command: %d", binding->param1);
+        return ZMK_BEHAVIOR_OPAQUE;
+    }
+
+    if (err) {
+        LOG_WRN("Display brightness command %d failed: %d", binding->param1, err);
+    }
+
+    return ZMK_BEHAVIOR_OPAQUE;
+}
+
+static int on_display_brightness_binding_released(struct zmk_behavior_binding *binding,
+                                                  struct zmk_behavior_binding_event event) {
+    return ZMK_BEHAVIOR_OPAQUE;
+}
+
+static const struct behavior_driver_api behavior_display_brightness_driver_api = {
+    .binding_pressed = on_display_brightness_binding_pressed,
+    .binding_released = on_display_brightness_binding_released,
+    .locality = BEHAVIOR_LOCALITY_CENTRAL,
+};
+
+static int behavior_display_brightness_init(const struct device *dev) { return 0; }
+
+BEHAVIOR_DT_INST_DEFINE(0, behavior_display_brightness_init, NULL, NULL, NULL, POST_KERNEL,
+                        CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+                        &behavior_display_brightness_driver_api);
+
+#endif
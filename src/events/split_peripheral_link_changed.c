@@ -0,0 +1,4 @@
+#include <zephyr/kernel.h>
+#include <zmk/events/split_peripheral_link_changed.h>
+
+ZMK_EVENT_IMPL(zmk_split_peripheral_link_changed);
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/util.h>
+
+#if IS_ENABLED(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include <zmk/ble.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/keycode_state_changed.h>
+#include <zmk/events/position_state_changed.h>
+
+#include <prospector/keystroke_latency.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// The split central stamps each position event with the uptime at which the
+// peripheral's notification arrived, and behaviors copy that timestamp into
+// the keycode events they raise. ZMK's HID listener sends the report while
+// handling the keycode event, before listeners from this module run, so the
+// time at which the keycode event reaches us closes the measurement. The
+// position event supplies the peripheral it came from. The two can reach this
+// module in either order and are joined on the shared timestamp.
+//
+// Timestamps are in milliseconds, which bounds the resolution.
+struct latency_sample {
+    int64_t timestamp;
+    int16_t slot;
+    int16_t latency_ms;
+};
+
+#define LATENCY_PENDING_SIZE 8
+#define LATENCY_UNKNOWN -1
+
+static struct latency_sample pending[LATENCY_PENDING_SIZE];
+static uint8_t pending_next;
+
+static struct prospector_latency_histogram histograms[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+static struct k_spinlock lock;
+
+static uint8_t latency_bucket(uint32_t latency_ms) {
+    if (latency_ms == 0) {
+        return 0;
+    }
+
+    return MIN(32 - __builtin_clz(latency_ms), PROSPECTOR_LATENCY_BUCKETS - 1);
+}
+
+static void latency_record(uint8_t slot, uint32_t latency_ms) {
+    struct prospector_latency_histogram *hist = &histograms[slot];
+
+    hist->buckets[latency_bucket(latency_ms)]++;
+    hist->count++;
+    hist->max_ms = MAX(hist->max_ms, latency_ms);
+}
+
+// Complete a pending sample with whichever half arrived second, or start a new
+// one, recycling the oldest entry if a press never produced a keycode
+static void latency_join(int64_t timestamp, int16_t slot, int16_t latency_ms) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (int i = 0; i < LATENCY_PENDING_SIZE; i++) {
+        struct latency_sample *sample = &pending[i];
+        if (sample->timestamp != timestamp) {
+            continue;
+        }
+
+        if (slot == LATENCY_UNKNOWN && sample->slot != LATENCY_UNKNOWN &&
+            sample->latency_ms == LATENCY_UNKNOWN) {
+            latency_record(sample->slot, latency_ms);
+            *sample = (struct latency_sample){0};
+            goto out;
+        }
+
+        if (slot != LATENCY_UNKNOWN && sample->latency_ms != LATENCY_UNKNOWN &&
+            sample->slot == LATENCY_UNKNOWN) {
+            latency_record(slot, sample->latency_ms);
+            *sample = (struct latency_sample){0};
+            goto out;
+        }
+    }
+
+    pending[pending_next] = (struct latency_sample){
+        .timestamp = timestamp,
+        .slot = slot,
+        .latency_ms = latency_ms,
+    };
+    pending_next = (pending_next + 1) % LATENCY_PENDING_SIZE;
+
+out:
+    k_spin_unlock(&lock, key);
+}
+
+static int keystroke_latency_listener(const zmk_event_t *eh) {
+    const struct zmk_position_state_changed *pos = as_zmk_position_state_changed(eh);
+    if (pos != NULL) {
+        if (pos->state && pos->source < ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+            latency_join(pos->timestamp, pos->source, LATENCY_UNKNOWN);
+        }
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    const struct zmk_keycode_state_changed *key = as_zmk_keycode_state_changed(eh);
+    if (key != NULL && key->state) {
+        int64_t latency_ms = k_uptime_get() - key->timestamp;
+        latency_join(key->timestamp, LATENCY_UNKNOWN, CLAMP(latency_ms, 0, INT16_MAX));
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(keystroke_latency, keystroke_latency_listener);
+ZMK_SUBSCRIPTION(keystroke_latency, zmk_position_state_changed);
+ZMK_SUBSCRIPTION(keystroke_latency, zmk_keycode_state_changed);
+
+int prospector_latency_get(uint8_t slot, struct prospector_latency_histogram *out) {
+    if (slot >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = histograms[slot];
+    k_spin_unlock(&lock, key);
+
+    return 0;
+}
+
+void prospector_latency_reset(void) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memset(histograms, 0, sizeof(histograms));
+    k_spin_unlock(&lock, key);
+}
+
+int prospector_latency_percentile(const struct prospector_latency_histogram *hist,
+                                  uint8_t percent) {
+    if (hist->count == 0) {
+        return -1;
+    }
+
+    uint32_t rank = DIV_ROUND_UP(hist->count * percent, 100);
+    uint32_t seen = 0;
+
+    for (int i = 0; i < PROSPECTOR_LATENCY_BUCKETS - 1; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            return MIN((uint32_t)BIT(i), hist->max_ms);
+        }
+    }
+
+    return hist->max_ms;
+}
+
+#if IS_ENABLED(CONFIG_SHELL)
+
+static int cmd_latency_show(const struct shell *sh, size_t argc, char **argv) {
+    for (uint8_t slot = 0; slot < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; slot++) {
+        struct prospector_latency_histogram hist;
+
+        prospector_latency_get(slot, &hist);
+        shell_print(sh, "Peripheral %d: %u presses, p50 <= %d ms, p95 <= %d ms, max %u ms", slot,
+                    hist.count, prospector_latency_percentile(&hist, 50),
+                    prospector_latency_percentile(&hist, 95), hist.max_ms);
+
+        for (int i = 0; i < PROSPECTOR_LATENCY_BUCKETS; i++) {
+            if (hist.buckets[i] == 0) {
+                continue;
+            }
+
+            if (i == PROSPECTOR_LATENCY_BUCKETS - 1) {
+                shell_print(sh, "  >= %4u ms: %u", (uint32_t)BIT(i - 1), hist.buckets[i]);
+            } else {
+                shell_print(sh, "  <  %4u ms: %u", (uint32_t)BIT(i), hist.buckets[i]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv) {
+    prospector_latency_reset();
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_latency, SHELL_CMD(show, NULL, "Show keystroke latency histograms", cmd_latency_show),
+    SHELL_CMD(reset, NULL, "Clear keystroke latency histograms", cmd_latency_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(latency, &sub_latency, "Split keystroke latency", NULL);
+
+#endif // IS_ENABLED(CONFIG_SHELL)
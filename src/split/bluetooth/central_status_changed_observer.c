@@ -20,6 +20,15 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/events/split_central_status_changed.h>
 
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_LINK_TELEMETRY)
+#include <zmk/events/split_peripheral_link_changed.h>
+#endif
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_ADAPTIVE_CONN_PARAMS)
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#endif
+
 enum psptr_peripheral_slot_state {
     PERIPHERAL_SLOT_STATE_OPEN,
     PERIPHERAL_SLOT_STATE_CONNECTING,
@@ -33,21 +42,16 @@ struct psptr_peripheral_slot {
 
 static struct psptr_peripheral_slot peripherals[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
 
-static int psptr_peripheral_slot_index_for_conn(struct bt_conn *conn) {
-    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
-        if (peripherals[i].conn == conn) {
-            return i;
-        }
-    }
-    return -EINVAL;
-}
+// Slot reserved for each connection indexed by bt_conn_index(), -1 when the
+// connection has none. Together with peripherals[].conn this maps both ways
+// without scanning, and it is the only source of slot numbers for the events.
+static int8_t conn_slots[CONFIG_BT_MAX_CONN] = {[0 ... CONFIG_BT_MAX_CONN - 1] = -1};
 
-static struct psptr_peripheral_slot *psptr_peripheral_slot_for_conn(struct bt_conn *conn) {
-    int idx = psptr_peripheral_slot_index_for_conn(conn);
-    if (idx < 0) {
-        return NULL;
-    }
-    return &peripherals[idx];
+BUILD_ASSERT(ZMK_SPLIT_BLE_PERIPHERAL_COUNT <= INT8_MAX, "Slot numbers must fit in conn_slots");
+
+static int psptr_peripheral_slot_index_for_conn(struct bt_conn *conn) {
+    int idx = conn_slots[bt_conn_index(conn)];
+    return idx < 0 ? -EINVAL : idx;
 }
 
 static int release_psptr_peripheral_slot(int index) {
@@ -64,6 +68,7 @@ static int release_psptr_peripheral_slot(int index) {
     LOG_DBG("Releasing peripheral slot at %d", index);
 
     if (slot->conn != NULL) {
+        conn_slots[bt_conn_index(slot->conn)] = -1;
         slot->conn = NULL;
     }
     slot->state = PERIPHERAL_SLOT_STATE_OPEN;
@@ -71,14 +76,22 @@ static int release_psptr_peripheral_slot(int index) {
     return 0;
 }
 
+static void assign_psptr_peripheral_slot(int index, struct bt_conn *conn) {
+    // Be sure the slot is fully reinitialized.
+    release_psptr_peripheral_slot(index);
+    peripherals[index].conn = conn;
+    peripherals[index].state = PERIPHERAL_SLOT_STATE_CONNECTED;
+    conn_slots[bt_conn_index(conn)] = index;
+}
+
 static int reserve_psptr_peripheral_slot_for_conn(struct bt_conn *conn) {
+    // A connection object reused without a disconnect must not keep its old slot
+    release_psptr_peripheral_slot(psptr_peripheral_slot_index_for_conn(conn));
+
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_PREF_WEAK_BOND)
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
         if (peripherals[i].state == PERIPHERAL_SLOT_STATE_OPEN) {
-            // Be sure the slot is fully reinitialized.
-            release_psptr_peripheral_slot(i);
-            peripherals[i].conn = conn;
-            peripherals[i].state = PERIPHERAL_SLOT_STATE_CONNECTED;
+            assign_psptr_peripheral_slot(i, conn);
             return i;
         }
     }
@@ -86,10 +99,7 @@ static int reserve_psptr_peripheral_slot_for_conn(struct bt_conn *conn) {
     int i = zmk_ble_put_peripheral_addr(bt_conn_get_dst(conn));
     if (i >= 0) {
         if (peripherals[i].state == PERIPHERAL_SLOT_STATE_OPEN) {
-            // Be sure the slot is fully reinitialized.
-            release_psptr_peripheral_slot(i);
-            peripherals[i].conn = conn;
-            peripherals[i].state = PERIPHERAL_SLOT_STATE_CONNECTED;
+            assign_psptr_peripheral_slot(i, conn);
             return i;
         }
     }
@@ -107,36 +117,360 @@ int release_psptr_peripheral_slot_for_conn(struct bt_conn *conn) {
     return release_psptr_peripheral_slot(idx);
 }
 
-static void split_central_process_connection(struct bt_conn *conn) {
-    int err;
+// Status changes are queued from the Bluetooth callbacks and raised from the
+// system work queue, so event subscribers never run on the BT RX path. Only
+// the slot bookkeeping stays in the callbacks since it has to follow the
+// connection order exactly.
+struct split_status_record {
+    // Referenced until the record has been processed
+    struct bt_conn *conn;
+    uint8_t slot;
+    bool connected;
+    uint8_t reason;
+};
+
+#define SPLIT_STATUS_QUEUE_SIZE (4 * ZMK_SPLIT_BLE_PERIPHERAL_COUNT)
+
+K_MSGQ_DEFINE(split_status_msgq, sizeof(struct split_status_record), SPLIT_STATUS_QUEUE_SIZE, 4);
+
+// FNV-1a over the address and its type, so widgets can tell peripherals
+// apart without holding on to the connection
+static uint32_t split_addr_hash(const bt_addr_le_t *addr) {
+    const uint8_t *bytes = (const uint8_t *)addr;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(*addr); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash ? hash : 1;
+}
+
+static void split_status_work_callback(struct k_work *work) {
+    struct split_status_record record;
+
+    while (k_msgq_get(&split_status_msgq, &record, K_NO_WAIT) == 0) {
+        const bt_addr_le_t *addr = bt_conn_get_dst(record.conn);
+        char addr_str[BT_ADDR_LE_STR_LEN];
+
+        bt_addr_le_to_str(addr, addr_str, sizeof(addr_str));
+
+        struct zmk_split_central_status_changed ev = {
+            .slot = record.slot,
+            .connected = record.connected,
+            .reason = record.reason,
+            .addr_hash = split_addr_hash(addr),
+        };
+
+        if (record.connected) {
+            struct bt_conn_info info;
+
+            bt_conn_get_info(record.conn, &info);
+
+            ev.interval = info.le.interval;
+            ev.latency = info.le.latency;
+            ev.timeout = info.le.timeout;
+
+            LOG_DBG("Connected: %s", addr_str);
+            LOG_DBG("Current security for connection: %d", bt_conn_get_security(record.conn));
+            LOG_DBG("New connection params: Interval: %d, Latency: %d, PHY: %d",
+                    info.le.interval, info.le.latency, info.le.phy->rx_phy);
+        } else {
+            LOG_DBG("Disconnected: %s (reason %d)", addr_str, record.reason);
+        }
+
+        bt_conn_unref(record.conn);
+
+        raise_zmk_split_central_status_changed(ev);
+    }
+}
+
+K_WORK_DEFINE(split_status_work, split_status_work_callback);
+
+static void split_central_queue_status(struct bt_conn *conn, int slot_idx, bool connected,
+                                       uint8_t reason) {
+    struct split_status_record record = {
+        .conn = bt_conn_ref(conn),
+        .slot = slot_idx,
+        .connected = connected,
+        .reason = reason,
+    };
+
+    if (k_msgq_put(&split_status_msgq, &record, K_NO_WAIT) != 0) {
+        LOG_WRN("Split status queue full, dropping status for slot %d", slot_idx);
+        bt_conn_unref(conn);
+        return;
+    }
+
+    k_work_submit(&split_status_work);
+}
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_LINK_TELEMETRY)
+
+// Link state per slot, written from the Bluetooth callbacks and the RSSI
+// sampler and published for every slot marked dirty from the system work queue
+static struct zmk_split_peripheral_link links[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+static struct k_spinlock links_lock;
+static atomic_t links_dirty;
+
+BUILD_ASSERT(ZMK_SPLIT_BLE_PERIPHERAL_COUNT <= ATOMIC_BITS, "Dirty slots must fit in an atomic_t");
+
+static void link_work_callback(struct k_work *work) {
+    atomic_val_t dirty = atomic_clear(&links_dirty);
+
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        if (!(dirty & BIT(i))) {
+            continue;
+        }
+
+        struct zmk_split_peripheral_link_changed ev = {.slot = i};
 
-    LOG_DBG("Current security for connection: %d", bt_conn_get_security(conn));
+        k_spinlock_key_t key = k_spin_lock(&links_lock);
+        ev.link = links[i];
+        k_spin_unlock(&links_lock, key);
+
+        raise_zmk_split_peripheral_link_changed(ev);
+    }
+}
+
+K_WORK_DEFINE(link_work, link_work_callback);
+
+static void link_publish(int slot) {
+    atomic_set_bit(&links_dirty, slot);
+    k_work_submit(&link_work);
+}
+
+static void link_connected(int slot, const struct bt_conn_info *info) {
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    // The reason of the previous disconnect is kept until the next one
+    links[slot].interval = info->le.interval;
+    links[slot].latency = info->le.latency;
+    links[slot].timeout = info->le.timeout;
+    links[slot].tx_phy = info->le.phy->tx_phy;
+    links[slot].rx_phy = info->le.phy->rx_phy;
+    links[slot].rssi = ZMK_SPLIT_PERIPHERAL_RSSI_UNKNOWN;
+    links[slot].connected = true;
+    k_spin_unlock(&links_lock, key);
+
+    link_publish(slot);
+}
+
+static void link_disconnected(int slot, uint8_t reason) {
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    links[slot].rssi = ZMK_SPLIT_PERIPHERAL_RSSI_UNKNOWN;
+    links[slot].disconnect_reason = reason;
+    links[slot].connected = false;
+    k_spin_unlock(&links_lock, key);
+
+    link_publish(slot);
+}
+
+static void split_central_le_param_updated(struct bt_conn *conn, uint16_t interval,
+                                           uint16_t latency, uint16_t timeout) {
+    int slot = psptr_peripheral_slot_index_for_conn(conn);
+    if (slot < 0) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    links[slot].interval = interval;
+    links[slot].latency = latency;
+    links[slot].timeout = timeout;
+    k_spin_unlock(&links_lock, key);
+
+    link_publish(slot);
+}
 
-    struct psptr_peripheral_slot *slot = psptr_peripheral_slot_for_conn(conn);
-    if (slot == NULL) {
-        LOG_ERR("No peripheral state found for connection");
+static void split_central_le_phy_updated(struct bt_conn *conn,
+                                         struct bt_conn_le_phy_info *param) {
+    int slot = psptr_peripheral_slot_index_for_conn(conn);
+    if (slot < 0) {
         return;
     }
 
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    links[slot].tx_phy = param->tx_phy;
+    links[slot].rx_phy = param->rx_phy;
+    k_spin_unlock(&links_lock, key);
+
+    link_publish(slot);
+}
+
+#if CONFIG_PROSPECTOR_SPLIT_LINK_RSSI_INTERVAL > 0
+
+static int link_read_rssi(struct bt_conn *conn, int8_t *rssi) {
+    struct bt_hci_cp_read_rssi *cp;
+    struct net_buf *buf, *rsp = NULL;
+    uint16_t handle;
+
+    int err = bt_hci_get_conn_handle(conn, &handle);
+    if (err) {
+        return err;
+    }
+
+    buf = bt_hci_cmd_create(BT_HCI_OP_READ_RSSI, sizeof(*cp));
+    if (buf == NULL) {
+        return -ENOBUFS;
+    }
+
+    cp = net_buf_add(buf, sizeof(*cp));
+    cp->handle = sys_cpu_to_le16(handle);
+
+    err = bt_hci_cmd_send_sync(BT_HCI_OP_READ_RSSI, buf, &rsp);
+    if (err) {
+        return err;
+    }
+
+    *rssi = ((struct bt_hci_rp_read_rssi *)rsp->data)->rssi;
+    net_buf_unref(rsp);
+
+    return 0;
+}
+
+static void link_sample_rssi(struct bt_conn *conn, void *data) {
+    int slot = psptr_peripheral_slot_index_for_conn(conn);
+    if (slot < 0) {
+        return;
+    }
+
+    int8_t rssi;
+    int err = link_read_rssi(conn, &rssi);
+    if (err) {
+        LOG_DBG("Failed to read RSSI for slot %d (err %d)", slot, err);
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    bool changed = links[slot].connected && links[slot].rssi != rssi;
+    if (changed) {
+        links[slot].rssi = rssi;
+    }
+    k_spin_unlock(&links_lock, key);
+
+    if (changed) {
+        link_publish(slot);
+    }
+}
+
+static void link_rssi_work_callback(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(link_rssi_work, link_rssi_work_callback);
+
+// HCI commands are synchronous, so sampling runs on the system work queue
+// rather than in a Bluetooth callback
+static void link_rssi_work_callback(struct k_work *work) {
+    bt_conn_foreach(BT_CONN_TYPE_LE, link_sample_rssi, NULL);
+    k_work_schedule(&link_rssi_work, K_SECONDS(CONFIG_PROSPECTOR_SPLIT_LINK_RSSI_INTERVAL));
+}
+
+#endif // CONFIG_PROSPECTOR_SPLIT_LINK_RSSI_INTERVAL > 0
+
+#endif // IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_LINK_TELEMETRY)
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_ADAPTIVE_CONN_PARAMS)
+
+// Split links run at the shortest interval while keys are being typed and
+// relax to a longer interval with peripheral latency once typing stops, so
+// both sides spend fewer radio events on an idle link
+static atomic_t conn_params_typing;
+static uint32_t typing_presses;
+static int64_t typing_since;
+
+// A peripheral skipping every event latency allows must still be heard from
+// before the link is dropped. The spec wants the supervision timeout, in 10 ms
+// units, above twice the effective interval of (1 + latency) * interval * 1.25 ms.
+#define CONN_PARAMS_TIMEOUT_VALID(interval, latency)                                               \
+    (CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT * 10 * 4 > ((latency) + 1) * (interval) * 5 * 2)
+
+BUILD_ASSERT(CONN_PARAMS_TIMEOUT_VALID(CONFIG_PROSPECTOR_SPLIT_IDLE_INTERVAL,
+                                       CONFIG_PROSPECTOR_SPLIT_IDLE_LATENCY),
+             "Supervision timeout too short for the idle interval and latency");
+BUILD_ASSERT(CONN_PARAMS_TIMEOUT_VALID(CONFIG_PROSPECTOR_SPLIT_TYPING_INTERVAL,
+                                       CONFIG_ZMK_SPLIT_BLE_PREF_LATENCY),
+             "Supervision timeout too short for the typing interval and latency");
+
+static struct bt_le_conn_param conn_params_for(bool typing) {
+    if (typing) {
+        return (struct bt_le_conn_param)BT_LE_CONN_PARAM_INIT(
+            CONFIG_PROSPECTOR_SPLIT_TYPING_INTERVAL, CONFIG_PROSPECTOR_SPLIT_TYPING_INTERVAL,
+            CONFIG_ZMK_SPLIT_BLE_PREF_LATENCY, CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT);
+    }
+
+    return (struct bt_le_conn_param)BT_LE_CONN_PARAM_INIT(
+        CONFIG_PROSPECTOR_SPLIT_IDLE_INTERVAL, CONFIG_PROSPECTOR_SPLIT_IDLE_INTERVAL,
+        CONFIG_PROSPECTOR_SPLIT_IDLE_LATENCY, CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT);
+}
+
+static void conn_params_apply_to(struct bt_conn *conn, void *data) {
+    const struct bt_le_conn_param *param = data;
     struct bt_conn_info info;
 
-    bt_conn_get_info(conn, &info);
+    if (psptr_peripheral_slot_index_for_conn(conn) < 0 || bt_conn_get_info(conn, &info) ||
+        (info.le.interval == param->interval_max && info.le.latency == param->latency)) {
+        return;
+    }
+
+    int err = bt_conn_le_param_update(conn, param);
+    if (err) {
+        LOG_WRN("Failed to update split connection parameters (err %d)", err);
+    }
+}
+
+static void conn_params_work_callback(struct k_work *work) {
+    bool typing = atomic_get(&conn_params_typing);
+    struct bt_le_conn_param param = conn_params_for(typing);
+
+    bt_conn_foreach(BT_CONN_TYPE_LE, conn_params_apply_to, &param);
+
+    // Estimated from the requested parameters, not measured: the peripheral
+    // may decline the update, and it only skips up to latency events while it
+    // has nothing to send, whereas the central attends every one of them
+    uint32_t events_per_min = 60 * 1000 * 4 / (param.interval_max * 5);
+    LOG_INF("Split links %s: interval %u us, latency %u, estimated %u central and at least %u "
+            "peripheral radio events per minute",
+            typing ? "typing" : "idle", param.interval_max * 1250, param.latency,
+            events_per_min, events_per_min / (param.latency + 1));
+}
+
+K_WORK_DEFINE(conn_params_work, conn_params_work_callback);
+
+static void conn_params_idle_callback(struct k_work *work) {
+    if (atomic_cas(&conn_params_typing, true, false)) {
+        LOG_INF("Typed %u keys in %d s", typing_presses,
+                (int)((k_uptime_get() - typing_since) / 1000));
+        k_work_submit(&conn_params_work);
+    }
+}
+
+K_WORK_DELAYABLE_DEFINE(conn_params_idle_work, conn_params_idle_callback);
+
+static int conn_params_listener(const zmk_event_t *eh) {
+    const struct zmk_position_state_changed *ev = as_zmk_position_state_changed(eh);
+    if (ev == NULL || !ev->state) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
 
-    LOG_DBG("New connection params: Interval: %d, Latency: %d, PHY: %d", info.le.interval,
-            info.le.latency, info.le.phy->rx_phy);
+    if (atomic_cas(&conn_params_typing, false, true)) {
+        typing_presses = 0;
+        typing_since = k_uptime_get();
+        k_work_submit(&conn_params_work);
+    }
+
+    typing_presses++;
+    k_work_reschedule(&conn_params_idle_work, K_MSEC(CONFIG_PROSPECTOR_SPLIT_IDLE_TIMEOUT));
 
-    raise_zmk_split_central_status_changed((struct zmk_split_central_status_changed){
-        .slot = peripheral_slot_index_for_conn(conn),
-        .connected = true,
-    });
+    return ZMK_EV_EVENT_BUBBLE;
 }
 
+ZMK_LISTENER(split_conn_params, conn_params_listener);
+ZMK_SUBSCRIPTION(split_conn_params, zmk_position_state_changed);
+
+#endif // IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_ADAPTIVE_CONN_PARAMS)
+
 static void split_central_connected(struct bt_conn *conn, uint8_t conn_err) {
-    char addr_str[BT_ADDR_LE_STR_LEN];
+    uint32_t start = k_cycle_get_32();
     struct bt_conn_info info;
 
-    bt_addr_le_to_str(bt_conn_get_dst(conn), addr_str, sizeof(addr_str));
-
     bt_conn_get_info(conn, &info);
 
     if (info.role != BT_CONN_ROLE_CENTRAL) {
@@ -145,51 +479,72 @@ static void split_central_connected(struct bt_conn *conn, uint8_t conn_err) {
     }
 
     if (conn_err) {
+        char addr_str[BT_ADDR_LE_STR_LEN];
+
+        bt_addr_le_to_str(bt_conn_get_dst(conn), addr_str, sizeof(addr_str));
         LOG_ERR("Failed to connect to %s (%u)", addr_str, conn_err);
         release_psptr_peripheral_slot_for_conn(conn);
         return;
     }
 
-    LOG_DBG("Connected: %s", addr_str);
-
     int slot_idx = reserve_psptr_peripheral_slot_for_conn(conn);
     if (slot_idx < 0) {
         LOG_ERR("Unable to reserve peripheral slot for connection (err %d)", slot_idx);
         return;
     }
 
-    split_central_process_connection(conn);
+    split_central_queue_status(conn, slot_idx, true, 0);
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_LINK_TELEMETRY)
+    link_connected(slot_idx, &info);
+#endif
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_ADAPTIVE_CONN_PARAMS)
+    // Bring the new link in line with the current typing state
+    k_work_submit(&conn_params_work);
+#endif
+
+    LOG_DBG("Connected callback took %u us", k_cyc_to_us_floor32(k_cycle_get_32() - start));
 }
 
 static void split_central_disconnected(struct bt_conn *conn, uint8_t reason) {
-    char addr_str[BT_ADDR_LE_STR_LEN];
-    int err;
+    uint32_t start = k_cycle_get_32();
 
-    bt_addr_le_to_str(bt_conn_get_dst(conn), addr_str, sizeof(addr_str));
+    int slot_idx = psptr_peripheral_slot_index_for_conn(conn);
+    if (slot_idx < 0) {
+        // Not a split peripheral, e.g. the host connection
+        return;
+    }
 
-    LOG_DBG("Disconnected: %s (reason %d)", addr_str, reason);
+    split_central_queue_status(conn, slot_idx, false, reason);
 
-    raise_zmk_split_central_status_changed((struct zmk_split_central_status_changed){
-        .slot = peripheral_slot_index_for_conn(conn),
-        .connected = false,
-    });
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_LINK_TELEMETRY)
+    link_disconnected(slot_idx, reason);
+#endif
 
     // k_msleep(100);
 
-    err = release_psptr_peripheral_slot_for_conn(conn);
+    release_psptr_peripheral_slot(slot_idx);
 
-    if (err < 0) {
-        return;
-    }
+    LOG_DBG("Disconnected callback took %u us", k_cyc_to_us_floor32(k_cycle_get_32() - start));
 }
 
 static struct bt_conn_cb conn_callbacks = {
     .connected = split_central_connected,
     .disconnected = split_central_disconnected,
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_LINK_TELEMETRY)
+    .le_param_updated = split_central_le_param_updated,
+    .le_phy_updated = split_central_le_phy_updated,
+#endif
 };
 
 static int zmk_split_bt_central_init(void) {
     bt_conn_cb_register(&conn_callbacks);
+
+#if IS_ENABLED(CONFIG_PROSPECTOR_SPLIT_LINK_TELEMETRY) && CONFIG_PROSPECTOR_SPLIT_LINK_RSSI_INTERVAL > 0
+    k_work_schedule(&link_rssi_work, K_SECONDS(CONFIG_PROSPECTOR_SPLIT_LINK_RSSI_INTERVAL));
+#endif
+
     return 0;
 }
 
@@ -0,0 +1,302 @@
+// Emulates the parts of the APDS9960 the brightness controller and the Zephyr
+// driver touch: the register file, the ALS and proximity engines with their
+// interrupt windows and persistence filters, and the active low INT line.
+// Both engines latch a new reading once per ALS integration time, which the
+// driver programs through ATIME.
+
+#define DT_DRV_COMPAT avago_apds9960
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "emul_apds9960.h"
+
+#define APDS9960_ENABLE_REG              0x80
+#define APDS9960_ENABLE_PON              BIT(0)
+#define APDS9960_ENABLE_AEN              BIT(1)
+#define APDS9960_ENABLE_PEN              BIT(2)
+#define APDS9960_ENABLE_AIEN             BIT(4)
+#define APDS9960_ENABLE_PIEN             BIT(5)
+#define APDS9960_ATIME_REG               0x81
+#define APDS9960_AILTL_REG               0x84
+#define APDS9960_AIHTL_REG               0x86
+#define APDS9960_PILT_REG                0x89
+#define APDS9960_PIHT_REG                0x8B
+#define APDS9960_PERS_REG                0x8C
+#define APDS9960_PERS_APERS_MASK         0x0F
+#define APDS9960_PERS_PPERS_SHIFT        4
+#define APDS9960_ID_REG                  0x92
+#define APDS9960_STATUS_REG              0x93
+#define APDS9960_STATUS_AVALID           BIT(0)
+#define APDS9960_STATUS_PVALID           BIT(1)
+#define APDS9960_STATUS_AINT             BIT(4)
+#define APDS9960_STATUS_PINT             BIT(5)
+#define APDS9960_CDATAL_REG              0x94
+#define APDS9960_PDATA_REG               0x9C
+#define APDS9960_PICLEAR_REG             0xE5
+#define APDS9960_CICLEAR_REG             0xE6
+#define APDS9960_AICLEAR_REG             0xE7
+
+#define APDS9960_ID                      0xAB
+
+// Length of one ATIME step of the ALS integration time
+#define APDS9960_ATIME_STEP_US           2780
+
+struct apds9960_emul_cfg {
+    struct gpio_dt_spec int_gpio;
+};
+
+struct apds9960_emul_data {
+    const struct emul *target;
+    struct k_timer cycle;
+    struct k_spinlock lock;
+    uint32_t cycle_us;
+    uint8_t regs[256];
+    uint8_t reg_addr;
+    uint16_t clear;
+    uint8_t proximity;
+    // Consecutive cycles with the reading outside the interrupt window
+    uint16_t als_outside;
+    uint16_t prox_outside;
+    bool int_asserted;
+    uint32_t clear_reads;
+    uint32_t interrupts;
+};
+
+// Cycles out of the window before AINT is set, 0 interrupts on every cycle
+static uint16_t apds9960_emul_apers_cycles(uint8_t apers) {
+    return apers < 4 ? apers : 5 * (apers - 3);
+}
+
+static void apds9960_emul_sync_int(const struct emul *target) {
+    struct apds9960_emul_data *data = target->data;
+    const struct apds9960_emul_cfg *cfg = target->cfg;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    uint8_t enable = data->regs[APDS9960_ENABLE_REG];
+    uint8_t status = data->regs[APDS9960_STATUS_REG];
+    bool asserted = ((status & APDS9960_STATUS_AINT) && (enable & APDS9960_ENABLE_AIEN)) ||
+                    ((status & APDS9960_STATUS_PINT) && (enable & APDS9960_ENABLE_PIEN));
+    bool changed = asserted != data->int_asserted;
+
+    data->int_asserted = asserted;
+    if (changed && asserted) {
+        data->interrupts++;
+    }
+    k_spin_unlock(&data->lock, key);
+
+    // Set outside the lock, the GPIO callbacks run right away
+    if (changed) {
+        gpio_emul_input_set(cfg->int_gpio.port, cfg->int_gpio.pin, asserted ? 0 : 1);
+    }
+}
+
+static void apds9960_emul_cycle(struct k_timer *timer) {
+    struct apds9960_emul_data *data = CONTAINER_OF(timer, struct apds9960_emul_data, cycle);
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    uint8_t *regs = data->regs;
+    uint8_t enable = regs[APDS9960_ENABLE_REG];
+    uint8_t pers = regs[APDS9960_PERS_REG];
+
+    if (enable & APDS9960_ENABLE_AEN) {
+        uint16_t low = sys_get_le16(&regs[APDS9960_AILTL_REG]);
+        uint16_t high = sys_get_le16(&regs[APDS9960_AIHTL_REG]);
+        uint16_t cycles = apds9960_emul_apers_cycles(pers & APDS9960_PERS_APERS_MASK);
+
+        sys_put_le16(data->clear, &regs[APDS9960_CDATAL_REG]);
+        regs[APDS9960_STATUS_REG] |= APDS9960_STATUS_AVALID;
+
+        data->als_outside = data->clear < low || data->clear > high ? data->als_outside + 1 : 0;
+        if (cycles == 0 || data->als_outside >= cycles) {
+            regs[APDS9960_STATUS_REG] |= APDS9960_STATUS_AINT;
+        }
+    }
+
+    if (enable & APDS9960_ENABLE_PEN) {
+        uint8_t low = regs[APDS9960_PILT_REG];
+        uint8_t high = regs[APDS9960_PIHT_REG];
+        uint16_t cycles = pers >> APDS9960_PERS_PPERS_SHIFT;
+
+        regs[APDS9960_PDATA_REG] = data->proximity;
+        regs[APDS9960_STATUS_REG] |= APDS9960_STATUS_PVALID;
+
+        data->prox_outside =
+            data->proximity < low || data->proximity > high ? data->prox_outside + 1 : 0;
+        if (cycles == 0 || data->prox_outside >= cycles) {
+            regs[APDS9960_STATUS_REG] |= APDS9960_STATUS_PINT;
+        }
+    }
+    k_spin_unlock(&data->lock, key);
+
+    apds9960_emul_sync_int(data->target);
+}
+
+// The engines run while the chip is powered and either of them is enabled
+static void apds9960_emul_update_cycle(struct apds9960_emul_data *data) {
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    uint8_t enable = data->regs[APDS9960_ENABLE_REG];
+    uint32_t cycle_us = 0;
+
+    if ((enable & APDS9960_ENABLE_PON) &&
+        (enable & (APDS9960_ENABLE_AEN | APDS9960_ENABLE_PEN))) {
+        cycle_us = (256 - data->regs[APDS9960_ATIME_REG]) * APDS9960_ATIME_STEP_US;
+    }
+
+    bool restart = cycle_us != data->cycle_us;
+    data->cycle_us = cycle_us;
+    k_spin_unlock(&data->lock, key);
+
+    if (!restart) {
+        return;
+    }
+
+    if (cycle_us) {
+        k_timer_start(&data->cycle, K_USEC(cycle_us), K_USEC(cycle_us));
+    } else {
+        k_timer_stop(&data->cycle);
+    }
+}
+
+static void apds9960_emul_write_reg(struct apds9960_emul_data *data, uint8_t reg, uint8_t value) {
+    switch (reg) {
+    case APDS9960_PICLEAR_REG:
+        data->regs[APDS9960_STATUS_REG] &= ~APDS9960_STATUS_PINT;
+        break;
+    case APDS9960_CICLEAR_REG:
+        data->regs[APDS9960_STATUS_REG] &= ~APDS9960_STATUS_AINT;
+        break;
+    case APDS9960_AICLEAR_REG:
+        data->regs[APDS9960_STATUS_REG] &= ~(APDS9960_STATUS_AINT | APDS9960_STATUS_PINT);
+        break;
+    case APDS9960_ID_REG:
+    case APDS9960_STATUS_REG ... APDS9960_PDATA_REG:
+        // Read only
+        break;
+    default:
+        data->regs[reg] = value;
+        break;
+    }
+}
+
+// The first byte written in a transaction selects the register, every byte
+// read or written after it moves on to the next one
+static int apds9960_emul_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs,
+                                  int addr) {
+    struct apds9960_emul_data *data = target->data;
+    bool addressed = false;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    for (int i = 0; i < num_msgs; i++) {
+        struct i2c_msg *msg = &msgs[i];
+        uint32_t j = 0;
+
+        if (msg->flags & I2C_MSG_READ) {
+            for (; j < msg->len; j++) {
+                if (data->reg_addr == APDS9960_CDATAL_REG) {
+                    data->clear_reads++;
+                }
+                msg->buf[j] = data->regs[data->reg_addr++];
+            }
+            continue;
+        }
+
+        if (!addressed) {
+            if (msg->len == 0) {
+                k_spin_unlock(&data->lock, key);
+                return -EIO;
+            }
+            data->reg_addr = msg->buf[j++];
+            addressed = true;
+        }
+
+        for (; j < msg->len; j++) {
+            apds9960_emul_write_reg(data, data->reg_addr++, msg->buf[j]);
+        }
+    }
+    k_spin_unlock(&data->lock, key);
+
+    apds9960_emul_update_cycle(data);
+    apds9960_emul_sync_int(target);
+    return 0;
+}
+
+static const struct i2c_emul_api apds9960_emul_api = {
+    .transfer = apds9960_emul_transfer,
+};
+
+void apds9960_emul_set_light(const struct emul *target, uint16_t clear) {
+    struct apds9960_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    data->clear = clear;
+    k_spin_unlock(&data->lock, key);
+}
+
+void apds9960_emul_set_proximity(const struct emul *target, uint8_t proximity) {
+    struct apds9960_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    data->proximity = proximity;
+    k_spin_unlock(&data->lock, key);
+}
+
+uint32_t apds9960_emul_take_clear_reads(const struct emul *target) {
+    struct apds9960_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    uint32_t reads = data->clear_reads;
+    data->clear_reads = 0;
+    k_spin_unlock(&data->lock, key);
+
+    return reads;
+}
+
+uint32_t apds9960_emul_take_interrupts(const struct emul *target) {
+    struct apds9960_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    uint32_t interrupts = data->interrupts;
+    data->interrupts = 0;
+    k_spin_unlock(&data->lock, key);
+
+    return interrupts;
+}
+
+static int apds9960_emul_init(const struct emul *target, const struct device *parent) {
+    struct apds9960_emul_data *data = target->data;
+    const struct apds9960_emul_cfg *cfg = target->cfg;
+
+    data->target = target;
+    data->regs[APDS9960_ATIME_REG] = 0xFF;
+    data->regs[APDS9960_ID_REG] = APDS9960_ID;
+    k_timer_init(&data->cycle, apds9960_emul_cycle, NULL);
+
+    if (!device_is_ready(cfg->int_gpio.port)) {
+        return -ENODEV;
+    }
+
+    // Nothing pulls the line low until the first interrupt
+    int err = gpio_pin_configure_dt(&cfg->int_gpio, GPIO_INPUT);
+    if (err) {
+        return err;
+    }
+
+    return gpio_emul_input_set(cfg->int_gpio.port, cfg->int_gpio.pin, 1);
+}
+
+#define APDS9960_EMUL(n)                                                                           \
+    static struct apds9960_emul_data apds9960_emul_data_##n;                                       \
+    static const struct apds9960_emul_cfg apds9960_emul_cfg_##n = {                                \
+        .int_gpio = GPIO_DT_SPEC_INST_GET(n, int_gpios),                                           \
+    };                                                                                             \
+    EMUL_DT_INST_DEFINE(n, apds9960_emul_init, &apds9960_emul_data_##n, &apds9960_emul_cfg_##n,    \
+                        &apds9960_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(APDS9960_EMUL)
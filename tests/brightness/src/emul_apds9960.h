@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+// Clear channel count the ALS engine latches at the end of its next
+// integration cycle
+void apds9960_emul_set_light(const struct emul *target, uint16_t clear);
+
+// Proximity count the proximity engine latches at the end of its next cycle
+void apds9960_emul_set_proximity(const struct emul *target, uint8_t proximity);
+
+// Reads of the clear channel since the last call, one per controller wakeup
+uint32_t apds9960_emul_take_clear_reads(const struct emul *target);
+
+// Times the INT line was asserted since the last call
+uint32_t apds9960_emul_take_interrupts(const struct emul *target);
@@ -0,0 +1,75 @@
+// Stands in for the PWM LED driver behind the backlight, recording every duty
+// cycle it is given with the time it was set
+
+#define DT_DRV_COMPAT pwm_leds
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led.h>
+
+#include "led_recorder.h"
+
+#define LED_RECORDER_SAMPLES             1024
+
+struct led_recorder_data {
+    struct k_spinlock lock;
+    struct led_recorder_sample samples[LED_RECORDER_SAMPLES];
+    size_t count;
+    bool overflowed;
+    uint8_t level;
+};
+
+static int led_recorder_set_brightness(const struct device *dev, uint32_t led, uint8_t value) {
+    struct led_recorder_data *data = dev->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    if (data->count < LED_RECORDER_SAMPLES) {
+        data->samples[data->count++] = (struct led_recorder_sample){
+            .at_ms = k_uptime_get(),
+            .level = value,
+        };
+    } else {
+        data->overflowed = true;
+    }
+    data->level = value;
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
+
+void led_recorder_reset(const struct device *dev) {
+    struct led_recorder_data *data = dev->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    data->count = 0;
+    data->overflowed = false;
+    k_spin_unlock(&data->lock, key);
+}
+
+const struct led_recorder_sample *led_recorder_samples(const struct device *dev, size_t *count) {
+    struct led_recorder_data *data = dev->data;
+
+    *count = data->count;
+    return data->samples;
+}
+
+bool led_recorder_overflowed(const struct device *dev) {
+    struct led_recorder_data *data = dev->data;
+
+    return data->overflowed;
+}
+
+uint8_t led_recorder_level(const struct device *dev) {
+    struct led_recorder_data *data = dev->data;
+
+    return data->level;
+}
+
+static const struct led_driver_api led_recorder_api = {
+    .set_brightness = led_recorder_set_brightness,
+};
+
+static struct led_recorder_data led_recorder_data;
+
+DEVICE_DT_INST_DEFINE(0, NULL, NULL, &led_recorder_data, NULL, POST_KERNEL,
+                      CONFIG_LED_INIT_PRIORITY, &led_recorder_api);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+// One duty cycle change of the backlight
+struct led_recorder_sample {
+    int64_t at_ms;
+    uint8_t level;
+};
+
+// Forget the recorded changes, the current level is kept
+void led_recorder_reset(const struct device *dev);
+
+// Changes recorded since the last reset, oldest first. Once the buffer is
+// full further changes only update the level and the overflow flag.
+const struct led_recorder_sample *led_recorder_samples(const struct device *dev, size_t *count);
+
+bool led_recorder_overflowed(const struct device *dev);
+
+// Level most recently written, whether recorded or not
+uint8_t led_recorder_level(const struct device *dev);
@@ -0,0 +1,315 @@
+// Closed-loop tests of the ambient light brightness controller. Lux traces are
+// replayed through the emulated APDS9960 and the backlight duty cycles the
+// controller produces are checked for settle time, overshoot, PWM updates and
+// wakeups. The metrics of every trace are printed so runs can be compared. The
+// backlight fades are timed step by step from the recorded duty cycles.
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+
+#include <backlight.h>
+#include <prospector_als_curve.h>
+
+#include "emul_apds9960.h"
+#include "led_recorder.h"
+
+// Time given to the controller to follow a change in light, and how long the
+// slowest fade, from full brightness to the minimum, may take to get there
+#define SETTLE_TIMEOUT_MS                4000
+#define SETTLE_BUDGET_MS                 2000
+
+// Polling reads the sensor once per sample period no matter what
+#define POLL_PERIOD_MS                   100
+
+// Time per 1% step of a backlight fade, brightening is quicker so the display
+// catches up with a lamp switched on, darkening is gentler on the eye
+#define FADE_BRIGHTEN_STEP_MS            3
+#define FADE_DARKEN_STEP_MS              10
+
+static const struct emul *const als = EMUL_DT_GET(DT_NODELABEL(apds9960));
+static const struct device *const backlight = DEVICE_DT_GET_ONE(pwm_leds);
+
+// Hold each clear channel count for hold_ms, in order
+struct lux_step {
+    uint16_t clear;
+    uint16_t hold_ms;
+};
+
+struct loop_metrics {
+    uint8_t start;
+    uint8_t level;
+    uint32_t pwm_updates;
+    // From the last change of light to the last duty cycle change
+    uint32_t settle_ms;
+    // Furthest the backlight went past its final level
+    uint32_t overshoot;
+    // Times the backlight changed direction
+    uint32_t reversals;
+    uint32_t wakeups;
+    uint32_t interrupts;
+};
+
+static uint8_t expected_level(uint16_t clear) {
+    return als_curve_lut[MIN(clear, ALS_CURVE_SENSOR_MAX)];
+}
+
+static void settle_at(uint16_t clear) {
+    apds9960_emul_set_light(als, clear);
+    k_sleep(K_MSEC(SETTLE_TIMEOUT_MS));
+
+    led_recorder_reset(backlight);
+    apds9960_emul_take_clear_reads(als);
+    apds9960_emul_take_interrupts(als);
+}
+
+static struct loop_metrics replay(const char *name, const struct lux_step *trace, size_t len) {
+    struct loop_metrics m = {.start = bl_get()};
+    int64_t last_change = k_uptime_get();
+    int32_t clear = -1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (trace[i].clear != clear) {
+            clear = trace[i].clear;
+            last_change = k_uptime_get();
+            apds9960_emul_set_light(als, clear);
+        }
+        k_sleep(K_MSEC(trace[i].hold_ms));
+    }
+
+    k_sleep(K_MSEC(SETTLE_TIMEOUT_MS));
+
+    size_t count;
+    const struct led_recorder_sample *samples = led_recorder_samples(backlight, &count);
+    zassert_false(led_recorder_overflowed(backlight), "%s: too many PWM updates to record",
+                  name);
+
+    m.level = bl_get();
+    m.pwm_updates = count;
+    m.wakeups = apds9960_emul_take_clear_reads(als);
+    m.interrupts = apds9960_emul_take_interrupts(als);
+
+    int prev = m.start;
+    int direction = 0;
+    for (size_t i = 0; i < count; i++) {
+        int level = samples[i].level;
+        int step = level > prev ? 1 : level < prev ? -1 : 0;
+
+        if (step != 0 && direction != 0 && step != direction) {
+            m.reversals++;
+        }
+        direction = step != 0 ? step : direction;
+        prev = level;
+
+        uint32_t past = m.level >= m.start ? MAX(level - m.level, 0) : MAX(m.level - level, 0);
+        m.overshoot = MAX(m.overshoot, past);
+    }
+
+    if (count > 0 && samples[count - 1].at_ms > last_change) {
+        m.settle_ms = samples[count - 1].at_ms - last_change;
+    }
+
+    TC_PRINT("%s: %u -> %u, %u PWM updates, settled in %u ms, overshoot %u, %u reversals, "
+             "%u wakeups, %u interrupts\n",
+             name, m.start, m.level, m.pwm_updates, m.settle_ms, m.overshoot, m.reversals,
+             m.wakeups, m.interrupts);
+
+    return m;
+}
+
+// The controller ends up on the curve for a reading within the hysteresis of
+// the final light, in one monotonic fade of one PWM update per step and in time
+static void assert_settled(const struct loop_metrics *m, uint16_t clear) {
+    uint8_t low = expected_level(MAX(clear - CONFIG_PROSPECTOR_ALS_HYSTERESIS, 0));
+    uint8_t high = expected_level(clear + CONFIG_PROSPECTOR_ALS_HYSTERESIS);
+
+    zassert_true(m->level >= low && m->level <= high, "ended at %u, curve gives %u-%u",
+                 m->level, low, high);
+    zassert_equal(m->overshoot, 0, "overshot by %u", m->overshoot);
+    zassert_equal(m->reversals, 0, "changed direction %u times", m->reversals);
+    zassert_true(m->pwm_updates <= abs(m->level - m->start), "%u PWM updates for %u -> %u",
+                 m->pwm_updates, m->start, m->level);
+    zassert_true(m->settle_ms <= SETTLE_BUDGET_MS, "settled in %u ms", m->settle_ms);
+}
+
+ZTEST(brightness, test_step_brighten) {
+    static const struct lux_step trace[] = {{.clear = ALS_CURVE_SENSOR_MAX, .hold_ms = 0}};
+
+    settle_at(0);
+    struct loop_metrics m = replay("step up", trace, ARRAY_SIZE(trace));
+    assert_settled(&m, ALS_CURVE_SENSOR_MAX);
+}
+
+ZTEST(brightness, test_step_darken) {
+    static const struct lux_step trace[] = {{.clear = 0, .hold_ms = 0}};
+
+    settle_at(ALS_CURVE_SENSOR_MAX);
+    struct loop_metrics m = replay("step down", trace, ARRAY_SIZE(trace));
+    assert_settled(&m, 0);
+}
+
+// A lamp being dimmed, one count every 50 ms over 5 s
+ZTEST(brightness, test_ramp) {
+    struct lux_step trace[ALS_CURVE_SENSOR_MAX + 1];
+
+    for (int i = 0; i <= ALS_CURVE_SENSOR_MAX; i++) {
+        trace[i] = (struct lux_step){.clear = ALS_CURVE_SENSOR_MAX - i, .hold_ms = 50};
+    }
+
+    settle_at(ALS_CURVE_SENSOR_MAX);
+    struct loop_metrics m = replay("ramp down", trace, ARRAY_SIZE(trace));
+    assert_settled(&m, 0);
+}
+
+static void jitter_trace(struct lux_step *trace, size_t len, uint16_t a, uint16_t b) {
+    for (size_t i = 0; i < len; i++) {
+        trace[i] = (struct lux_step){.clear = i % 2 ? b : a, .hold_ms = POLL_PERIOD_MS};
+    }
+}
+
+// Readings jittering around a steady level stay inside the hysteresis and
+// must not move the backlight
+ZTEST(brightness, test_flicker) {
+    struct lux_step trace[50];
+
+    jitter_trace(trace, ARRAY_SIZE(trace), 49, 51);
+
+    // Coming from the dark the applied reading ends up on the jitter's centre
+    settle_at(0);
+    settle_at(50);
+    struct loop_metrics m = replay("flicker", trace, ARRAY_SIZE(trace));
+    zassert_equal(m.pwm_updates, 0, "%u PWM updates", m.pwm_updates);
+}
+
+// In the dark a single count moves the curve by several %, the jitter of a
+// dim room must still not keep restarting fades
+ZTEST(brightness, test_low_light_jitter) {
+    struct lux_step trace[50];
+
+    settle_at(0);
+
+    jitter_trace(trace, ARRAY_SIZE(trace), 1, 2);
+    struct loop_metrics m = replay("jitter 1/2", trace, ARRAY_SIZE(trace));
+    zassert_equal(m.pwm_updates, 0, "%u PWM updates", m.pwm_updates);
+
+    // Out of the band around 0, so one fade to the new level and no more
+    jitter_trace(trace, ARRAY_SIZE(trace), 2, 3);
+    led_recorder_reset(backlight);
+    m = replay("jitter 2/3", trace, ARRAY_SIZE(trace));
+    zassert_equal(m.reversals, 0, "changed direction %u times", m.reversals);
+    zassert_true(m.pwm_updates <= expected_level(3) - expected_level(0),
+                 "%u PWM updates", m.pwm_updates);
+}
+
+// Polling wakes up every sample period, the interrupt mode not at all while
+// the light stays inside its window
+ZTEST(brightness, test_steady_wakeups) {
+    static const struct lux_step trace[] = {{.clear = 30, .hold_ms = 10000}};
+
+    settle_at(30);
+    struct loop_metrics m = replay("steady", trace, ARRAY_SIZE(trace));
+    zassert_equal(m.pwm_updates, 0, "%u PWM updates", m.pwm_updates);
+
+    uint32_t periods = (10000 + SETTLE_TIMEOUT_MS) / POLL_PERIOD_MS;
+    if (IS_ENABLED(CONFIG_PROSPECTOR_ALS_INTERRUPT)) {
+        zassert_equal(m.wakeups, 0, "%u wakeups", m.wakeups);
+        zassert_equal(m.interrupts, 0, "%u interrupts", m.interrupts);
+    } else {
+        zassert_within(m.wakeups, periods, 2, "%u wakeups in %u periods", m.wakeups, periods);
+    }
+}
+
+// A fade writes every level between start and target once, each step the
+// fade period after the previous one, give or take the tick a timeout rounds
+// up to
+static void assert_fade_steps(const struct led_recorder_sample *samples, size_t count,
+                              int64_t started, uint8_t from) {
+    int64_t prev_at = started;
+    int prev = from;
+
+    for (size_t i = 0; i < count; i++) {
+        int level = samples[i].level;
+        int64_t elapsed = samples[i].at_ms - prev_at;
+
+        zassert_equal(abs(level - prev), 1, "jumped from %d to %d", prev, level);
+
+        // The first step is written right away
+        if (i > 0) {
+            int32_t period = level > prev ? FADE_BRIGHTEN_STEP_MS : FADE_DARKEN_STEP_MS;
+            zassert_true(elapsed >= period && elapsed <= period + 1,
+                         "step %d -> %d after %d ms, expected %d ms", prev, level, (int)elapsed,
+                         period);
+        }
+
+        prev = level;
+        prev_at = samples[i].at_ms;
+    }
+}
+
+// Hold the light steady so the controller leaves the backlight to the test
+static uint8_t fade_test_start(void) {
+    settle_at(ALS_CURVE_SENSOR_MAX / 2);
+    return bl_get();
+}
+
+static void fade_test_end(uint8_t level) {
+    bl_fade_to(level);
+    k_sleep(K_MSEC(SETTLE_TIMEOUT_MS));
+    zassert_equal(bl_get(), level);
+}
+
+ZTEST(brightness, test_fade_timing) {
+    uint8_t start = fade_test_start();
+    size_t count;
+
+    int64_t started = k_uptime_get();
+    bl_fade_to(100);
+    k_sleep(K_MSEC(SETTLE_TIMEOUT_MS));
+
+    const struct led_recorder_sample *samples = led_recorder_samples(backlight, &count);
+    zassert_equal(count, 100 - start, "%zu PWM updates for %u -> 100", count, start);
+    assert_fade_steps(samples, count, started, start);
+
+    led_recorder_reset(backlight);
+    started = k_uptime_get();
+    bl_fade_to(1);
+    k_sleep(K_MSEC(SETTLE_TIMEOUT_MS));
+
+    samples = led_recorder_samples(backlight, &count);
+    zassert_equal(count, 99, "%zu PWM updates for 100 -> 1", count);
+    assert_fade_steps(samples, count, started, 100);
+
+    fade_test_end(start);
+}
+
+// A new target in the middle of a fade carries on from the level reached,
+// stepping back without a jump or a restart from the old start
+ZTEST(brightness, test_fade_retarget) {
+    uint8_t start = fade_test_start();
+    size_t count;
+
+    bl_fade_to(1);
+    k_sleep(K_MSEC(20 * FADE_DARKEN_STEP_MS));
+    uint8_t reached = bl_get();
+    zassert_true(reached < start && reached > 1, "fade at %u", reached);
+
+    led_recorder_reset(backlight);
+    int64_t started = k_uptime_get();
+    bl_fade_to(100);
+    k_sleep(K_MSEC(SETTLE_TIMEOUT_MS));
+
+    const struct led_recorder_sample *samples = led_recorder_samples(backlight, &count);
+    zassert_equal(count, 100 - reached, "%zu PWM updates for %u -> 100", count, reached);
+    zassert_equal(samples[0].level, reached + 1, "continued at %u from %u", samples[0].level,
+                  reached);
+    // The step already pending runs when it was due, not a full period later
+    zassert_true(samples[0].at_ms - started <= FADE_DARKEN_STEP_MS + 1, "first step after %d ms",
+                 (int)(samples[0].at_ms - started));
+    assert_fade_steps(samples, count, started, reached);
+
+    fade_test_end(start);
+}
+
+ZTEST_SUITE(brightness, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,128 @@
+// Tests of how brightness changes are persisted. A settings backend stands in
+// for flash, keeping the last value saved and counting the writes, so the
+// debouncing can be checked without a storage partition.
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/ztest.h>
+#include <string.h>
+
+#include <prospector/brightness.h>
+
+// Layout of the "prospector/brightness" value as brightness.c stores it
+struct saved_brightness {
+    bool manual;
+    uint8_t level;
+    int8_t offset;
+};
+
+static struct {
+    uint32_t writes;
+    char name[SETTINGS_MAX_NAME_LEN + 1];
+    uint8_t value[16];
+    size_t len;
+} saved;
+
+static int test_store_load(struct settings_store *cs, const struct settings_load_arg *arg) {
+    return 0;
+}
+
+static int test_store_save(struct settings_store *cs, const char *name, const char *value,
+                           size_t val_len) {
+    if (val_len > sizeof(saved.value)) {
+        return -ENOMEM;
+    }
+
+    strncpy(saved.name, name, SETTINGS_MAX_NAME_LEN);
+    memcpy(saved.value, value, val_len);
+    saved.len = val_len;
+    saved.writes++;
+
+    return 0;
+}
+
+static const struct settings_store_itf test_store_itf = {
+    .csi_load = test_store_load,
+    .csi_save = test_store_save,
+};
+
+static struct settings_store test_store = {
+    .cs_itf = &test_store_itf,
+};
+
+int settings_backend_init(void) {
+    settings_src_register(&test_store);
+    settings_dst_register(&test_store);
+
+    return 0;
+}
+
+#define DEBOUNCE_MS                      CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE
+
+// Keypresses on a brightness key come well inside the debounce of each other
+#define ADJUST_INTERVAL_MS               (DEBOUNCE_MS / 4)
+#define ADJUST_PRESSES                   24
+
+static void *brightness_settings_setup(void) {
+    zassert_ok(settings_subsys_init());
+    return NULL;
+}
+
+static void brightness_settings_before(void *fixture) {
+    // Let a save left pending by an earlier test go out first
+    k_sleep(K_MSEC(2 * DEBOUNCE_MS));
+    memset(&saved, 0, sizeof(saved));
+}
+
+static void brightness_settings_after(void *fixture) {
+    prospector_brightness_set_auto(0);
+    k_sleep(K_MSEC(2 * DEBOUNCE_MS));
+}
+
+ZTEST(brightness_settings, test_adjust_debounced) {
+    struct saved_brightness value;
+    int8_t expected = 0;
+
+    zassert_ok(prospector_brightness_set_auto(0));
+    for (int i = 0; i < ADJUST_PRESSES; i++) {
+        // Up most of the way, then back down, so the last value differs from
+        // the peak and from every value a premature save could have caught
+        int8_t delta = i < ADJUST_PRESSES * 3 / 4 ? 2 : -1;
+
+        zassert_ok(prospector_brightness_adjust(delta));
+        expected += delta;
+        k_sleep(K_MSEC(ADJUST_INTERVAL_MS));
+    }
+
+    // The burst lasted several debounce periods, none of them quiet
+    zassert_true(ADJUST_PRESSES * ADJUST_INTERVAL_MS > 2 * DEBOUNCE_MS);
+    zassert_equal(saved.writes, 0, "saved %u times during the burst", saved.writes);
+
+    k_sleep(K_MSEC(DEBOUNCE_MS + ADJUST_INTERVAL_MS));
+
+    zassert_equal(saved.writes, 1, "saved %u times", saved.writes);
+    zassert_equal(strcmp(saved.name, "prospector/brightness"), 0, "saved as %s", saved.name);
+    zassert_equal(saved.len, sizeof(value), "saved %zu bytes", saved.len);
+
+    memcpy(&value, saved.value, sizeof(value));
+    zassert_false(value.manual);
+    zassert_equal(value.offset, expected, "saved offset %d, last set %d", value.offset, expected);
+    zassert_equal(prospector_brightness_get_offset(), expected);
+}
+
+ZTEST(brightness_settings, test_quiet_adjust_saved_each) {
+    zassert_ok(prospector_brightness_set(40));
+    k_sleep(K_MSEC(DEBOUNCE_MS + ADJUST_INTERVAL_MS));
+    zassert_ok(prospector_brightness_adjust(5));
+    k_sleep(K_MSEC(DEBOUNCE_MS + ADJUST_INTERVAL_MS));
+
+    zassert_equal(saved.writes, 2, "saved %u times", saved.writes);
+
+    struct saved_brightness value;
+    memcpy(&value, saved.value, sizeof(value));
+    zassert_true(value.manual);
+    zassert_equal(value.level, 45, "saved level %u", value.level);
+}
+
+ZTEST_SUITE(brightness_settings, NULL, brightness_settings_setup, brightness_settings_before,
+            brightness_settings_after, NULL);
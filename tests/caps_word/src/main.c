@@ -0,0 +1,206 @@
+// Tests of the caps word behavior: the continue-list bitmaps against the scan
+// of the list they replace, and the state event shared by all instances. The
+// behavior is included whole so its static state and helpers can be reached,
+// ZMK itself is replaced by the stand-ins under tests/zmk.
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <string.h>
+
+#include "behavior_caps_word.c"
+
+static const struct device *caps_word_dev = DEVICE_DT_GET(DT_NODELABEL(caps_word));
+static const struct device *caps_word_num_dev = DEVICE_DT_GET(DT_NODELABEL(caps_word_num));
+
+static zmk_mod_flags_t explicit_mods;
+
+zmk_mod_flags_t zmk_hid_get_explicit_mods(void) { return explicit_mods; }
+
+// Values of every caps word state event raised since the last reset
+static struct {
+    bool active[8];
+    size_t count;
+} state_events;
+
+int zmk_event_manager_raise(zmk_event_t *event) {
+    const struct zmk_caps_word_state_changed *ev = as_zmk_caps_word_state_changed(event);
+
+    if (ev != NULL && state_events.count < ARRAY_SIZE(state_events.active)) {
+        state_events.active[state_events.count++] = ev->active;
+    }
+
+    return 0;
+}
+
+// The continue-list lookup before the bitmaps, a scan of every entry
+static bool linear_is_caps_includelist(const struct behavior_caps_word_config *config,
+                                       uint16_t usage_page, uint32_t usage_id,
+                                       uint8_t implicit_modifiers) {
+    uint8_t mods = implicit_modifiers | zmk_hid_get_explicit_mods();
+
+    for (int i = 0; i < config->continuations_count; i++) {
+        const struct caps_word_continue_item *continuation = &config->continuations[i];
+
+        if (continuation->page == usage_page && continuation->id == usage_id &&
+            (continuation->implicit_modifiers & mods) == continuation->implicit_modifiers) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// No modifiers, each one alone and all of them, as implicit and explicit mods
+static const uint8_t mod_cases[] = {
+    0,        MOD_LCTL, MOD_LSFT, MOD_LALT, MOD_LGUI, MOD_RCTL,
+    MOD_RSFT, MOD_RALT, MOD_RGUI, MOD_LCTL | MOD_LSFT, 0xFF,
+};
+
+static void assert_lookup_matches_scan(const struct device *dev, uint16_t usage_page) {
+    const struct behavior_caps_word_config *config = dev->config;
+    uint32_t continued = 0;
+
+    for (uint32_t id = 0; id <= UINT16_MAX; id++) {
+        for (size_t i = 0; i < ARRAY_SIZE(mod_cases); i++) {
+            for (size_t e = 0; e < ARRAY_SIZE(mod_cases); e++) {
+                explicit_mods = mod_cases[e];
+
+                bool expected = linear_is_caps_includelist(config, usage_page, id, mod_cases[i]);
+                bool found = caps_word_is_caps_includelist(config, usage_page, id, mod_cases[i]);
+
+                zassert_equal(found, expected,
+                              "%s: 0x%02X - 0x%04X with mods 0x%02X | 0x%02X: %d, scan %d",
+                              dev->name, usage_page, id, mod_cases[i], explicit_mods, found,
+                              expected);
+                continued += found;
+            }
+        }
+    }
+
+    // Guard against both sides rejecting everything
+    zassert_true(continued > 0, "%s: nothing on page 0x%02X continues", dev->name, usage_page);
+}
+
+static void caps_word_before(void *fixture) {
+    atomic_clear(&active_instances);
+    explicit_mods = 0;
+    memset(&state_events, 0, sizeof(state_events));
+}
+
+ZTEST(caps_word, test_bitmaps_match_scan_keyboard) {
+    assert_lookup_matches_scan(caps_word_dev, HID_USAGE_KEY);
+    assert_lookup_matches_scan(caps_word_num_dev, HID_USAGE_KEY);
+}
+
+ZTEST(caps_word, test_bitmaps_match_scan_consumer) {
+    assert_lookup_matches_scan(caps_word_dev, HID_USAGE_CONSUMER);
+    assert_lookup_matches_scan(caps_word_num_dev, HID_USAGE_CONSUMER);
+}
+
+// A few of the listed entries spelled out, so a shared mistake in the list
+// parsing can't make the comparison above pass
+ZTEST(caps_word, test_bitmaps_entries) {
+    const struct behavior_caps_word_config *config = caps_word_dev->config;
+
+    zassert_true(caps_word_key_bit(config->key_continue, 0x00));
+    zassert_true(caps_word_key_bit(config->key_continue, 0x1F));
+    zassert_true(caps_word_key_bit(config->key_continue, 0x20));
+    zassert_true(caps_word_key_bit(config->key_continue, 0xFF));
+    zassert_true(caps_word_key_bit(config->key_conditional, 0x3F));
+    zassert_true(caps_word_key_bit(config->key_conditional, 0xFE));
+    zassert_false(caps_word_key_bit(config->key_continue, 0x3F));
+    zassert_false(caps_word_key_bit(config->key_continue, 0x21));
+
+    // Unshifted minus is listed on its own, so the underscore entry does not
+    // add a modifier requirement to it
+    zassert_true(caps_word_is_caps_includelist(config, HID_USAGE_KEY,
+                                               HID_USAGE_KEY_KEYBOARD_MINUS_AND_UNDERSCORE, 0));
+    // Both modifiers of the entry are needed, from either source
+    zassert_false(caps_word_is_caps_includelist(config, HID_USAGE_KEY, 0x40, MOD_LSFT));
+    explicit_mods = MOD_LCTL;
+    zassert_true(caps_word_is_caps_includelist(config, HID_USAGE_KEY, 0x40, MOD_LSFT));
+    // Past the bitmaps the list is still consulted
+    zassert_true(caps_word_is_caps_includelist(config, HID_USAGE_KEY, 0x100, 0));
+    zassert_true(caps_word_is_caps_includelist(config, HID_USAGE_KEY, 0x101, MOD_LSFT));
+    zassert_true(caps_word_is_caps_includelist(config, HID_USAGE_KEY, 0xFFFF, 0));
+}
+
+static void press(const struct device *dev) {
+    struct zmk_behavior_binding binding = {.behavior_dev = dev->name};
+
+    on_caps_word_binding_pressed(&binding, (struct zmk_behavior_binding_event){0});
+}
+
+static void assert_state_events(const bool *expected, size_t count) {
+    zassert_equal(state_events.count, count, "%zu state events, expected %zu",
+                  state_events.count, count);
+    for (size_t i = 0; i < count; i++) {
+        zassert_equal(state_events.active[i], expected[i], "event %zu active %d", i,
+                      state_events.active[i]);
+    }
+}
+
+ZTEST(caps_word, test_state_event_on_any_active_transitions) {
+    press(caps_word_dev);
+    press(caps_word_num_dev);
+    zassert_true(caps_word_is_active(caps_word_dev));
+    zassert_true(caps_word_is_active(caps_word_num_dev));
+
+    // Turning the first one off leaves caps word on
+    press(caps_word_dev);
+    zassert_false(caps_word_is_active(caps_word_dev));
+    // And back on while the other one still is
+    press(caps_word_dev);
+    press(caps_word_num_dev);
+    press(caps_word_dev);
+
+    assert_state_events((const bool[]){true, false}, 2);
+    zassert_equal(atomic_get(&active_instances), 0);
+}
+
+ZTEST(caps_word, test_state_event_on_break) {
+    struct zmk_keycode_state_changed_event ev = {
+        .header = {.event = &zmk_event_zmk_keycode_state_changed},
+        .data = {.usage_page = HID_USAGE_KEY,
+                 .keycode = HID_USAGE_KEY_KEYBOARD_MINUS_AND_UNDERSCORE,
+                 .state = true},
+    };
+
+    press(caps_word_dev);
+    press(caps_word_num_dev);
+
+    // Unshifted minus continues the first instance only
+    caps_word_keycode_state_changed_listener(&ev.header);
+    zassert_true(caps_word_is_active(caps_word_dev));
+    zassert_false(caps_word_is_active(caps_word_num_dev));
+
+    ev.data.keycode = HID_USAGE_KEY_KEYBOARD_SPACEBAR;
+    caps_word_keycode_state_changed_listener(&ev.header);
+    zassert_false(caps_word_is_active(caps_word_dev));
+
+    assert_state_events((const bool[]){true, false}, 2);
+}
+
+ZTEST(caps_word, test_listener_returns_early_when_inactive) {
+    struct zmk_keycode_state_changed_event ev = {
+        .header = {.event = &zmk_event_zmk_keycode_state_changed},
+        .data = {.usage_page = HID_USAGE_KEY, .keycode = HID_USAGE_KEY_KEYBOARD_A, .state = true},
+    };
+
+    // An active instance shifts letters, so an unshifted one shows the
+    // listener left before looking at the instances
+    zassert_equal(caps_word_keycode_state_changed_listener(&ev.header), ZMK_EV_EVENT_BUBBLE);
+    zassert_equal(ev.data.implicit_modifiers, 0);
+
+    // A break key with nothing active deactivates nothing and raises nothing
+    ev.data.keycode = HID_USAGE_KEY_KEYBOARD_SPACEBAR;
+    caps_word_keycode_state_changed_listener(&ev.header);
+    zassert_equal(state_events.count, 0);
+
+    press(caps_word_num_dev);
+    ev.data.keycode = HID_USAGE_KEY_KEYBOARD_A;
+    caps_word_keycode_state_changed_listener(&ev.header);
+    zassert_equal(ev.data.implicit_modifiers, MOD_RSFT);
+}
+
+ZTEST_SUITE(caps_word, NULL, NULL, caps_word_before, NULL, NULL);
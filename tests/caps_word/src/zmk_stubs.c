@@ -0,0 +1,16 @@
+// The parts of ZMK behavior_caps_word.c links against, reduced to what the
+// tests need
+
+#include <zephyr/device.h>
+#include <zephyr/logging/log.h>
+
+#include <zmk/behavior.h>
+#include <zmk/events/keycode_state_changed.h>
+
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+ZMK_EVENT_IMPL(zmk_keycode_state_changed);
+
+const struct device *zmk_behavior_get_binding(const char *name) {
+    return device_get_binding(name);
+}
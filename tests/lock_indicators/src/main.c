@@ -0,0 +1,109 @@
+// Checks that a lock change redraws only the glyph showing that lock. The
+// widget is laid out on the dummy display, each lock is toggled through its
+// indicator callback, and the areas LVGL marks for redraw are compared with
+// the glyph's.
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include <lvgl.h>
+
+#include <indicators.h>
+
+#include "lock_indicators.h"
+
+// The widget logs to ZMK's module
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+static struct indicator_subscriber *subscriber;
+
+void indicators_subscribe(struct indicator_subscriber *sub) { subscriber = sub; }
+
+static const uint8_t lock_bits[ZMK_WIDGET_LOCK_COUNT] = {
+    [ZMK_WIDGET_LOCK_CAPS] = INDICATOR_CAPS_LOCK,
+    [ZMK_WIDGET_LOCK_NUM] = INDICATOR_NUM_LOCK,
+    [ZMK_WIDGET_LOCK_SCROLL] = INDICATOR_SCROLL_LOCK,
+};
+
+static struct zmk_widget_lock_indicators widget;
+
+// Bounding box and total size of the areas waiting to be redrawn, false when
+// there are none
+static bool invalidated(lv_area_t *bounds, uint32_t *pixels) {
+    lv_disp_t *disp = lv_disp_get_default();
+    bool any = false;
+
+    *pixels = 0;
+    for (int i = 0; i < disp->inv_p; i++) {
+        const lv_area_t *area = &disp->inv_areas[i];
+
+        *pixels += lv_area_get_size(area);
+        if (any) {
+            _lv_area_join(bounds, bounds, area);
+        } else {
+            *bounds = *area;
+            any = true;
+        }
+    }
+
+    return any;
+}
+
+static void toggle_lock(int lock, bool on) {
+    struct indicator_state state = {.flags = on ? BIT(lock_bits[lock]) : 0};
+    lv_obj_t *glyph = widget.glyphs[lock];
+    lv_area_t bounds;
+    uint32_t pixels;
+
+    subscriber->cb(&state, BIT(lock_bits[lock]));
+
+    // A label draws slightly past its box for overhanging letters, and LVGL
+    // redraws that margin with it
+    lv_area_t box = glyph->coords;
+    lv_coord_t ext = lv_obj_get_ext_draw_size(glyph);
+    lv_area_increase(&box, ext, ext);
+
+    zassert_true(invalidated(&bounds, &pixels), "lock %d %s: nothing to redraw", lock,
+                 on ? "on" : "off");
+    zassert_true(_lv_area_is_in(&bounds, &box, 0),
+                 "lock %d %s: redraws (%d,%d)-(%d,%d), glyph is (%d,%d)-(%d,%d)", lock,
+                 on ? "on" : "off", bounds.x1, bounds.y1, bounds.x2, bounds.y2, box.x1, box.y1,
+                 box.x2, box.y2);
+    zassert_true(pixels <= lv_area_get_size(&box), "lock %d %s: %u px redrawn for a %u px glyph",
+                 lock, on ? "on" : "off", pixels, (uint32_t)lv_area_get_size(&box));
+
+    lv_refr_now(NULL);
+}
+
+ZTEST(lock_indicators, test_toggle_redraws_glyph_only) {
+    for (int i = 0; i < ZMK_WIDGET_LOCK_COUNT; i++) {
+        toggle_lock(i, true);
+        toggle_lock(i, false);
+    }
+}
+
+ZTEST(lock_indicators, test_glyphs_smaller_than_screen) {
+    // Otherwise the check above would pass with the whole screen redrawn
+    uint32_t screen = lv_disp_get_hor_res(NULL) * lv_disp_get_ver_res(NULL);
+
+    for (int i = 0; i < ZMK_WIDGET_LOCK_COUNT; i++) {
+        zassert_true(lv_area_get_size(&widget.glyphs[i]->coords) < screen / 10,
+                     "lock %d glyph covers %u px", i,
+                     (uint32_t)lv_area_get_size(&widget.glyphs[i]->coords));
+    }
+}
+
+static void *lock_indicators_setup(void) {
+    zassert_ok(zmk_widget_lock_indicators_init(&widget, lv_scr_act()));
+    zassert_not_null(subscriber, "widget did not subscribe");
+    lv_obj_center(zmk_widget_lock_indicators_obj(&widget));
+    return NULL;
+}
+
+static void lock_indicators_before(void *fixture) {
+    // Lay out and draw everything pending, so only what the test changes is
+    // left to redraw
+    lv_refr_now(NULL);
+}
+
+ZTEST_SUITE(lock_indicators, NULL, lock_indicators_setup, lock_indicators_before, NULL, NULL);
@@ -0,0 +1,383 @@
+// Stress test of the split central status observer. Peripherals connect,
+// disconnect and reconnect on every slot faster than the system work queue
+// raises their events, and each event must still arrive once and in order,
+// with every connection reference the observer took released again. The
+// observer is included whole to reach its slot bookkeeping and queue, the
+// Bluetooth stack is replaced by the connection objects below.
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/hci.h>
+#include <string.h>
+
+// Keep the callbacks the observer registers at boot
+static struct bt_conn_cb *conn_cb;
+
+static void test_conn_cb_register(struct bt_conn_cb *cb) { conn_cb = cb; }
+
+#define bt_conn_cb_register test_conn_cb_register
+#include "central_status_changed_observer.c"
+#undef bt_conn_cb_register
+
+#define PERIPHERALS ZMK_SPLIT_BLE_PERIPHERAL_COUNT
+
+// Connection objects as the stack keeps them: one reference while connected,
+// reusable once the last reference is gone
+struct bt_conn {
+    uint8_t index;
+    uint8_t role;
+    atomic_t ref;
+    bt_addr_le_t dst;
+};
+
+static struct bt_conn conns[CONFIG_BT_MAX_CONN];
+static atomic_t unref_underflows;
+
+static const struct bt_conn_le_phy_info conn_phy = {
+    .tx_phy = BT_GAP_LE_PHY_2M,
+    .rx_phy = BT_GAP_LE_PHY_2M,
+};
+
+#define CONN_INTERVAL 6
+#define CONN_TIMEOUT 400
+
+uint8_t bt_conn_index(const struct bt_conn *conn) { return conn->index; }
+
+const bt_addr_le_t *bt_conn_get_dst(const struct bt_conn *conn) { return &conn->dst; }
+
+struct bt_conn *bt_conn_ref(struct bt_conn *conn) {
+    atomic_inc(&conn->ref);
+    return conn;
+}
+
+void bt_conn_unref(struct bt_conn *conn) {
+    if (atomic_dec(&conn->ref) <= 0) {
+        atomic_inc(&unref_underflows);
+    }
+}
+
+int bt_conn_get_info(const struct bt_conn *conn, struct bt_conn_info *info) {
+    *info = (struct bt_conn_info){
+        .type = BT_CONN_TYPE_LE,
+        .role = conn->role,
+        .le =
+            {
+                .dst = &conn->dst,
+                .interval = CONN_INTERVAL,
+                .timeout = CONN_TIMEOUT,
+                .phy = &conn_phy,
+            },
+    };
+    return 0;
+}
+
+bt_security_t bt_conn_get_security(const struct bt_conn *conn) { return BT_SECURITY_L2; }
+
+// Every status event raised, in order
+#define RECORDED_EVENTS 4096
+
+static struct {
+    struct zmk_split_central_status_changed events[RECORDED_EVENTS];
+    size_t count;
+    size_t overflowed;
+} recorded;
+
+int zmk_event_manager_raise(zmk_event_t *event) {
+    const struct zmk_split_central_status_changed *ev =
+        as_zmk_split_central_status_changed(event);
+
+    if (ev != NULL) {
+        if (recorded.count < RECORDED_EVENTS) {
+            recorded.events[recorded.count++] = *ev;
+        } else {
+            recorded.overflowed++;
+        }
+    }
+
+    return 0;
+}
+
+// What the observer should raise for the callbacks fired so far
+static struct {
+    struct zmk_split_central_status_changed events[RECORDED_EVENTS];
+    size_t count;
+} expected;
+
+// Connection each slot is on, NULL while the peripheral is away
+static struct bt_conn *slot_conns[PERIPHERALS];
+static struct bt_conn *host_conn;
+static uint32_t rand_state;
+
+static uint32_t next_rand(void) {
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 16;
+}
+
+// A free connection object, as the stack hands out for a new link, or NULL
+// while all of them are still referenced
+static struct bt_conn *conn_alloc(uint8_t role, uint8_t addr) {
+    size_t start = next_rand() % ARRAY_SIZE(conns);
+
+    for (size_t i = 0; i < ARRAY_SIZE(conns); i++) {
+        struct bt_conn *conn = &conns[(start + i) % ARRAY_SIZE(conns)];
+
+        if (atomic_get(&conn->ref) == 0) {
+            atomic_set(&conn->ref, 1);
+            conn->role = role;
+            conn->dst = (bt_addr_le_t){.type = BT_ADDR_LE_RANDOM, .a.val = {addr, 0xAB}};
+            return conn;
+        }
+    }
+
+    return NULL;
+}
+
+static void expect(int slot, bool connected, uint8_t reason) {
+    const bt_addr_le_t addr = {.type = BT_ADDR_LE_RANDOM, .a.val = {slot, 0xAB}};
+
+    zassert_true(expected.count < RECORDED_EVENTS);
+    expected.events[expected.count++] = (struct zmk_split_central_status_changed){
+        .slot = slot,
+        .connected = connected,
+        .reason = reason,
+        .addr_hash = split_addr_hash(&addr),
+        .interval = connected ? CONN_INTERVAL : 0,
+        .timeout = connected ? CONN_TIMEOUT : 0,
+    };
+}
+
+static bool peripheral_connect(int slot) {
+    struct bt_conn *conn = conn_alloc(BT_CONN_ROLE_CENTRAL, slot);
+    if (conn == NULL) {
+        return false;
+    }
+
+    conn_cb->connected(conn, 0);
+    slot_conns[slot] = conn;
+    expect(slot, true, 0);
+    return true;
+}
+
+static void peripheral_disconnect(int slot, uint8_t reason) {
+    struct bt_conn *conn = slot_conns[slot];
+
+    conn_cb->disconnected(conn, reason);
+    // The stack lets go of the connection once the callbacks returned
+    bt_conn_unref(conn);
+    slot_conns[slot] = NULL;
+    expect(slot, false, reason);
+}
+
+// A connection attempt the controller gave up on, which raises nothing
+static bool peripheral_connect_failed(int slot) {
+    struct bt_conn *conn = conn_alloc(BT_CONN_ROLE_CENTRAL, slot);
+    if (conn == NULL) {
+        return false;
+    }
+
+    conn_cb->connected(conn, BT_HCI_ERR_UNKNOWN_CONN_ID);
+    bt_conn_unref(conn);
+    return true;
+}
+
+static const uint8_t disconnect_reasons[] = {
+    BT_HCI_ERR_REMOTE_USER_TERM_CONN,
+    BT_HCI_ERR_CONN_TIMEOUT,
+    BT_HCI_ERR_LOCALHOST_TERM_CONN,
+};
+
+// One callback on a random slot: the peripheral drops off when it is
+// connected and comes back, or fails to, when it is not. Returns whether a
+// status event is due.
+static bool peripheral_random_step(void) {
+    int slot = next_rand() % PERIPHERALS;
+
+    if (slot_conns[slot] != NULL) {
+        uint8_t reason = disconnect_reasons[next_rand() % ARRAY_SIZE(disconnect_reasons)];
+
+        peripheral_disconnect(slot, reason);
+        return true;
+    }
+
+    if (next_rand() % 8 == 0) {
+        peripheral_connect_failed(slot);
+        return false;
+    }
+
+    return peripheral_connect(slot);
+}
+
+// Let the system work queue raise everything queued so far
+static void drain(void) {
+    while (k_msgq_num_used_get(&split_status_msgq) > 0 || k_work_busy_get(&split_status_work)) {
+        k_sleep(K_MSEC(1));
+    }
+}
+
+static void assert_events_match(void) {
+    zassert_equal(recorded.overflowed, 0);
+    zassert_equal(recorded.count, expected.count, "%zu events raised, %zu expected",
+                  recorded.count, expected.count);
+
+    for (size_t i = 0; i < expected.count; i++) {
+        const struct zmk_split_central_status_changed *got = &recorded.events[i];
+        const struct zmk_split_central_status_changed *want = &expected.events[i];
+
+        zassert_true(got->slot == want->slot && got->connected == want->connected &&
+                         got->reason == want->reason && got->addr_hash == want->addr_hash &&
+                         got->interval == want->interval && got->timeout == want->timeout,
+                     "event %zu: slot %u %s (reason %u), expected slot %u %s (reason %u)", i,
+                     got->slot, got->connected ? "connected" : "disconnected", got->reason,
+                     want->slot, want->connected ? "connected" : "disconnected", want->reason);
+    }
+}
+
+// Everything the observer took is given back once all peripherals are gone
+static void assert_released(void) {
+    for (int i = 0; i < PERIPHERALS; i++) {
+        if (slot_conns[i] != NULL) {
+            peripheral_disconnect(i, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        }
+    }
+    drain();
+
+    zassert_equal(atomic_get(&unref_underflows), 0, "connections unreferenced too often");
+    for (size_t i = 0; i < ARRAY_SIZE(conns); i++) {
+        long ref = atomic_get(&conns[i].ref);
+
+        zassert_equal(ref, &conns[i] == host_conn ? 1 : 0, "connection %zu holds %ld refs", i,
+                      ref);
+        zassert_equal(conn_slots[i], -1, "connection %zu still on slot %d", i, conn_slots[i]);
+    }
+    for (int i = 0; i < PERIPHERALS; i++) {
+        zassert_equal(peripherals[i].state, PERIPHERAL_SLOT_STATE_OPEN, "slot %d not open", i);
+        zassert_is_null(peripherals[i].conn);
+    }
+}
+
+static void split_status_before(void *fixture) {
+    memset(&recorded, 0, sizeof(recorded));
+    memset(&expected, 0, sizeof(expected));
+    for (size_t i = 0; i < ARRAY_SIZE(conns); i++) {
+        conns[i] = (struct bt_conn){.index = i};
+    }
+    atomic_clear(&unref_underflows);
+    rand_state = 0x5EED;
+
+    // The host stays connected throughout, the observer must leave it alone
+    host_conn = conn_alloc(BT_CONN_ROLE_PERIPHERAL, 0xFF);
+    conn_cb->connected(host_conn, 0);
+}
+
+static void split_status_after(void *fixture) {
+    conn_cb->disconnected(host_conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    bt_conn_unref(host_conn);
+    host_conn = NULL;
+}
+
+#define STRESS_STEPS 3000
+
+// Bursts as long as the queue, fired with the work queue held off as a busy
+// Bluetooth RX thread would, then raised in one go
+ZTEST(split_status, test_bursts) {
+    size_t queued = 0;
+
+    k_sched_lock();
+    for (int i = 0; i < STRESS_STEPS; i++) {
+        queued += peripheral_random_step();
+        if (queued == SPLIT_STATUS_QUEUE_SIZE) {
+            k_sched_unlock();
+            drain();
+            k_sched_lock();
+            queued = 0;
+        }
+    }
+    k_sched_unlock();
+
+    assert_released();
+    assert_events_match();
+}
+
+// Callbacks from a thread below the work queue, which raises each status as
+// soon as it is queued, mixed with bursts of random length
+ZTEST(split_status, test_interleaved) {
+    int prio = k_thread_priority_get(k_current_get());
+    bool locked = false;
+    size_t queued = 0;
+
+    k_thread_priority_set(k_current_get(), K_LOWEST_APPLICATION_THREAD_PRIO);
+
+    for (int i = 0; i < STRESS_STEPS; i++) {
+        if (!locked && next_rand() % 2 == 0) {
+            k_sched_lock();
+            locked = true;
+            queued = 0;
+        }
+
+        queued += peripheral_random_step();
+
+        if (locked && (queued == SPLIT_STATUS_QUEUE_SIZE || next_rand() % 4 == 0)) {
+            k_sched_unlock();
+            locked = false;
+        }
+    }
+    if (locked) {
+        k_sched_unlock();
+    }
+
+    k_thread_priority_set(k_current_get(), prio);
+
+    assert_released();
+    assert_events_match();
+}
+
+// A peripheral that reconnects on the connection object it just dropped must
+// get the same slot, with the stale mapping of the object cleared first
+ZTEST(split_status, test_reconnect_same_conn) {
+    struct bt_conn *conn = conn_alloc(BT_CONN_ROLE_CENTRAL, 1);
+
+    zassert_not_null(conn);
+    for (int i = 0; i < 4; i++) {
+        conn_cb->connected(conn, 0);
+        expect(1, true, 0);
+        conn_cb->disconnected(conn, BT_HCI_ERR_CONN_TIMEOUT);
+        expect(1, false, BT_HCI_ERR_CONN_TIMEOUT);
+        drain();
+    }
+    bt_conn_unref(conn);
+
+    assert_released();
+    assert_events_match();
+}
+
+// Past its size the queue drops statuses, but never a reference
+ZTEST(split_status, test_queue_overflow_releases_refs) {
+    size_t fired = 0;
+
+    k_sched_lock();
+    while (fired < SPLIT_STATUS_QUEUE_SIZE + 2) {
+        bool connected = peripheral_connect(0);
+
+        if (!connected) {
+            k_sched_unlock();
+            zassert_unreachable("out of connection objects");
+        }
+        peripheral_disconnect(0, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        fired += 2;
+    }
+    k_sched_unlock();
+
+    // Only what fit in the queue is raised
+    expected.count = SPLIT_STATUS_QUEUE_SIZE;
+
+    assert_released();
+    assert_events_match();
+}
+
+static void *split_status_setup(void) {
+    zassert_not_null(conn_cb, "observer registered no callbacks");
+    return NULL;
+}
+
+ZTEST_SUITE(split_status, NULL, split_status_setup, split_status_before, split_status_after, NULL);
@@ -0,0 +1,16 @@
+#pragma once
+
+// Stand-in for ZMK's header, the usage ids behavior_caps_word.c and its tests use
+
+#define HID_USAGE_KEY_KEYBOARD_A 0x04
+#define HID_USAGE_KEY_KEYBOARD_Z 0x1D
+#define HID_USAGE_KEY_KEYBOARD_1_AND_EXCLAMATION 0x1E
+#define HID_USAGE_KEY_KEYBOARD_0_AND_RIGHT_PARENTHESIS 0x27
+#define HID_USAGE_KEY_KEYBOARD_DELETE_BACKSPACE 0x2A
+#define HID_USAGE_KEY_KEYBOARD_SPACEBAR 0x2C
+#define HID_USAGE_KEY_KEYBOARD_MINUS_AND_UNDERSCORE 0x2D
+#define HID_USAGE_KEY_KEYBOARD_DELETE_FORWARD 0x4C
+#define HID_USAGE_KEY_KEYBOARD_LEFTCONTROL 0xE0
+#define HID_USAGE_KEY_KEYBOARD_RIGHT_GUI 0xE7
+
+#define HID_USAGE_CONSUMER_VOLUME_INCREMENT 0xE9
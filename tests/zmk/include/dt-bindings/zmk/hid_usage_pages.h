@@ -0,0 +1,6 @@
+#pragma once
+
+// Stand-in for ZMK's header, the usage pages the caps word tests use
+
+#define HID_USAGE_KEY 0x07
+#define HID_USAGE_CONSUMER 0x0C
@@ -0,0 +1,11 @@
+#pragma once
+
+// Stand-in for ZMK's header, behaviors are plain devices here
+
+#include <zephyr/device.h>
+
+#define ZMK_BEHAVIOR_OPAQUE 0
+
+#define BEHAVIOR_DT_INST_DEFINE DEVICE_DT_INST_DEFINE
+
+const struct device *zmk_behavior_get_binding(const char *name);
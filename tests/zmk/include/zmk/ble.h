@@ -0,0 +1,10 @@
+#pragma once
+
+// Stand-in for ZMK's header, the split central parts
+
+#include <zephyr/bluetooth/addr.h>
+
+#define ZMK_SPLIT_BLE_PERIPHERAL_COUNT CONFIG_ZMK_SPLIT_BLE_CENTRAL_PERIPHERALS
+
+// Slot of a bonded peripheral, or a free one for a new peripheral
+int zmk_ble_put_peripheral_addr(const bt_addr_le_t *addr);
@@ -0,0 +1,3 @@
+#pragma once
+
+// Stand-in for ZMK's header, included by the widgets but not used by them
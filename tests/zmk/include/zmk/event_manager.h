@@ -0,0 +1,47 @@
+#pragma once
+
+// Stand-in for ZMK's event manager. Events are declared and defined with the
+// same macros, but raising one hands it to zmk_event_manager_raise(), which
+// the test implements, and listeners are called by the test directly.
+
+#include <zephyr/toolchain.h>
+#include <zephyr/sys/util.h>
+
+struct zmk_event_type {
+    const char *name;
+};
+
+typedef struct {
+    const struct zmk_event_type *event;
+} zmk_event_t;
+
+#define ZMK_EV_EVENT_BUBBLE 0
+
+typedef int (*zmk_listener_callback_t)(const zmk_event_t *eh);
+
+#define ZMK_EVENT_DECLARE(event_type)                                                              \
+    struct event_type##_event {                                                                    \
+        zmk_event_t header;                                                                        \
+        struct event_type data;                                                                    \
+    };                                                                                             \
+    extern const struct zmk_event_type zmk_event_##event_type;                                     \
+    struct event_type *as_##event_type(const zmk_event_t *eh);                                     \
+    int raise_##event_type(struct event_type data)
+
+#define ZMK_EVENT_IMPL(event_type)                                                                 \
+    const struct zmk_event_type zmk_event_##event_type = {.name = STRINGIFY(event_type)};          \
+    struct event_type *as_##event_type(const zmk_event_t *eh) {                                    \
+        return eh->event == &zmk_event_##event_type ? &((struct event_type##_event *)eh)->data    \
+                                                    : NULL;                                        \
+    }                                                                                              \
+    int raise_##event_type(struct event_type data) {                                               \
+        struct event_type##_event ev = {.header = {.event = &zmk_event_##event_type},             \
+                                        .data = data};                                             \
+        return zmk_event_manager_raise(&ev.header);                                                \
+    }
+
+#define ZMK_LISTENER(mod, cb) static __unused const zmk_listener_callback_t zmk_listener_##mod = cb
+
+#define ZMK_SUBSCRIPTION(mod, ev_type) extern const struct zmk_event_type zmk_event_##ev_type
+
+int zmk_event_manager_raise(zmk_event_t *event);
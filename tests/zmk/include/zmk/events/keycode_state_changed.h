@@ -0,0 +1,19 @@
+#pragma once
+
+// Stand-in for ZMK's header with the same fields
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zmk/event_manager.h>
+#include <zmk/keys.h>
+
+struct zmk_keycode_state_changed {
+    uint16_t usage_page;
+    uint32_t keycode;
+    uint8_t implicit_modifiers;
+    uint8_t explicit_modifiers;
+    bool state;
+    int64_t timestamp;
+};
+
+ZMK_EVENT_DECLARE(zmk_keycode_state_changed);
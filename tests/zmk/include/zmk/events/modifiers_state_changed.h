@@ -0,0 +1,3 @@
+#pragma once
+
+// Stand-in for ZMK's header, included by behavior_caps_word.c but not used
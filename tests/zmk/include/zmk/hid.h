@@ -0,0 +1,7 @@
+#pragma once
+
+// Stand-in for ZMK's header, the modifiers held are set by the test
+
+#include <zmk/keys.h>
+
+zmk_mod_flags_t zmk_hid_get_explicit_mods(void);
@@ -0,0 +1,14 @@
+#pragma once
+
+// Stand-in for ZMK's header, what behavior_caps_word.c uses
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <dt-bindings/zmk/keys.h>
+
+typedef uint8_t zmk_mod_flags_t;
+
+static inline bool is_mod(uint8_t usage_page, uint32_t usage_id) {
+    return usage_page == HID_USAGE_KEY && usage_id >= HID_USAGE_KEY_KEYBOARD_LEFTCONTROL &&
+           usage_id <= HID_USAGE_KEY_KEYBOARD_RIGHT_GUI;
+}